@@ -0,0 +1,269 @@
+#include "BatchServer.h"
+#include "../Export/Encoders.h"
+#include "../Renderer/Color.h"
+#include "../Renderer/Profiler.h"
+#include "../Renderer/Rasterizer.h"
+#include "../Scene/Scene.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace Batch
+{
+	namespace
+	{
+		bool EndsWith(const std::string& text, const std::string& suffix)
+		{
+			return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+		double Percentile(const std::vector<double>& sorted, double percentile)
+		{
+			if (sorted.empty())
+			{
+				return 0.0;
+			}
+
+			// Nearest rank
+			size_t rank = (size_t)(percentile / 100.0 * sorted.size() + 0.999999);
+			return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+		}
+	}
+
+	bool ParseJob(const std::string& line, Job& job)
+	{
+		std::istringstream stream(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (stream >> token)
+		{
+			tokens.push_back(token);
+		}
+
+		if (tokens.size() < 3 || tokens[0][0] == '#')
+		{
+			return false;
+		}
+
+		job.scene = tokens[0];
+		job.width = (uint32_t)atoi(tokens[1].c_str());
+		job.height = (uint32_t)atoi(tokens[2].c_str());
+		job.cameraX = 0.0f;
+		job.cameraY = 0.0f;
+		job.zoom = 1.0f;
+		job.output.clear();
+
+		size_t next = 3;
+		if (tokens.size() >= 6)
+		{
+			job.cameraX = (float)atof(tokens[3].c_str());
+			job.cameraY = (float)atof(tokens[4].c_str());
+			job.zoom = (float)atof(tokens[5].c_str());
+			next = 6;
+		}
+		if (next < tokens.size())
+		{
+			job.output = tokens[next];
+		}
+
+		return job.width > 0 && job.height > 0 && job.zoom > 0.0f;
+	}
+
+	BatchServer::BatchServer(std::ostream& results, uint32_t threads, uint32_t maxPixels)
+		: mColorPool(4, maxPixels, threads ? threads : std::max(std::thread::hardware_concurrency(), 1u)),
+		mDepthPool(4, maxPixels, mColorPool.GetCount()),
+		mMaxPixels(maxPixels), mSubmitted(0), mCompleted(0), mFailed(0), mExit(false), mResults(&results)
+	{
+		for (uint32_t i = 0; i < mColorPool.GetCount(); i++)
+		{
+			mWorkers.push_back(std::thread(&BatchServer::WorkerLoop, this));
+		}
+	}
+
+	BatchServer::~BatchServer()
+	{
+		Finish();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mExit = true;
+		}
+		mJobReady.notify_all();
+
+		for (std::thread& worker : mWorkers)
+		{
+			worker.join();
+		}
+	}
+
+	bool BatchServer::Submit(Job job)
+	{
+		if ((uint64_t)job.width * job.height > mMaxPixels)
+		{
+			return false;
+		}
+
+		job.submitted = std::chrono::steady_clock::now();
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mSubmitted == 0)
+			{
+				mFirstSubmit = job.submitted;
+			}
+			job.id = mSubmitted++;
+			mJobs.push_back(job);
+		}
+		mJobReady.notify_one();
+		return true;
+	}
+
+	void BatchServer::Finish()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mJobDone.wait(lock, [&]() { return mCompleted == mSubmitted; });
+	}
+
+	uint32_t BatchServer::Run(std::istream& input)
+	{
+		uint32_t invalid = 0;
+		std::string line;
+		while (std::getline(input, line))
+		{
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos || line[first] == '#')
+			{
+				continue;
+			}
+
+			Job job;
+			if (!ParseJob(line, job) || !Submit(job))
+			{
+				std::lock_guard<std::mutex> lock(mResultsMutex);
+				*mResults << "invalid " << line << std::endl;
+				invalid++;
+			}
+		}
+
+		Finish();
+		return invalid;
+	}
+
+	void BatchServer::WorkerLoop()
+	{
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mJobReady.wait(lock, [&]() { return mExit || !mJobs.empty(); });
+				if (mJobs.empty())
+				{
+					return;
+				}
+				job = mJobs.front();
+				mJobs.pop_front();
+			}
+
+			Renderer::Buffer* color = mColorPool.Acquire();
+			Renderer::Buffer* depth = mDepthPool.Acquire();
+			bool succeeded = Render(job, *color, *depth);
+			mDepthPool.Release(depth);
+			mColorPool.Release(color);
+
+			auto completed = std::chrono::steady_clock::now();
+			double latency = std::chrono::duration<double, std::milli>(completed - job.submitted).count();
+
+			// Stream result right away, consumers see jobs in completion order
+			{
+				std::lock_guard<std::mutex> lock(mResultsMutex);
+				*mResults << (succeeded ? "done " : "failed ") << job.id << " " << job.scene << " " << job.width << "x" << job.height
+					<< " " << latency << " ms" << (job.output.empty() ? "" : " ") << job.output << std::endl;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mLatencies.push_back(latency);
+				mLastComplete = completed;
+				mFailed += succeeded ? 0 : 1;
+				mCompleted++;
+			}
+			mJobDone.notify_all();
+		}
+	}
+
+	bool BatchServer::Render(const Job& job, Renderer::Buffer& color, Renderer::Buffer& depth)
+	{
+		Scenes::Scene scene;
+		if (!Scenes::Create(job.scene, job.width, job.height, scene))
+		{
+			return false;
+		}
+
+		// Camera in screen space: pan, then zoom around the image center
+		float centerX = job.width * 0.5f;
+		float centerY = job.height * 0.5f;
+		for (Renderer::Vertex& v : scene.vertices)
+		{
+			v.position.x = (v.position.x - centerX - job.cameraX) * job.zoom + centerX;
+			v.position.y = (v.position.y - centerY - job.cameraY) * job.zoom + centerY;
+		}
+
+		// Pool buffers are sized for the largest job, only the first width * height elements are used
+		uint32_t pixels = job.width * job.height;
+		uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+		color.Fill(&clearColor, 0, pixels);
+		depth.Fill(&scene.clearDepth, 0, pixels);
+
+		Renderer::Rasterizer rasterizer(&color, &depth, job.width, job.height);
+		for (size_t i = 0; i + 2 < scene.vertices.size(); i += 3)
+		{
+			rasterizer.DrawTriangle(scene.vertices[i], scene.vertices[i + 1], scene.vertices[i + 2]);
+		}
+
+		if (job.output.empty())
+		{
+			return true;
+		}
+
+		std::vector<uint8_t> encoded;
+		if (EndsWith(job.output, ".qoi"))
+		{
+			Export::EncodeQOI((const uint32_t*)color.GetData(), job.width, job.height, encoded);
+		}
+		else if (EndsWith(job.output, ".ppm"))
+		{
+			Export::EncodePPM((const uint32_t*)color.GetData(), job.width, job.height, encoded);
+		}
+		else
+		{
+			return false;
+		}
+
+		FILE* file = fopen(job.output.c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+		bool written = fwrite(encoded.data(), 1, encoded.size(), file) == encoded.size();
+		return fclose(file) == 0 && written;
+	}
+
+	void BatchServer::PublishStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::vector<double> sorted = mLatencies;
+		std::sort(sorted.begin(), sorted.end());
+
+		double seconds = mCompleted ? std::chrono::duration<double>(mLastComplete - mFirstSubmit).count() : 0.0;
+
+		Renderer::Profiler& profiler = Renderer::Profiler::Get();
+		profiler.Set("batch.jobs", (double)mCompleted);
+		profiler.Set("batch.failed", (double)mFailed);
+		profiler.Set("batch.jobsPerSecond", seconds > 0.0 ? mCompleted / seconds : 0.0);
+		profiler.Set("batch.latencyP50Ms", Percentile(sorted, 50.0));
+		profiler.Set("batch.latencyP90Ms", Percentile(sorted, 90.0));
+		profiler.Set("batch.latencyP99Ms", Percentile(sorted, 99.0));
+		profiler.Set("batch.latencyMaxMs", sorted.empty() ? 0.0 : sorted.back());
+	}
+}
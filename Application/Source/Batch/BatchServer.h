@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../Renderer/BufferPool.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Batch
+{
+	/**
+	 * @struct Job
+	 * @brief One independent image, parsed from a line "<scene> <width> <height> [<x> <y> <zoom>] [<output>]".
+	 *
+	 * Camera pans the screen space scene by x, y pixels and zooms around the image center. Output is a .ppm or
+	 * .qoi path, without it the image is rendered and discarded (useful for throughput runs).
+	 */
+	struct Job
+	{
+		uint64_t id;
+		std::string scene;
+		uint32_t width;
+		uint32_t height;
+		float cameraX;
+		float cameraY;
+		float zoom;
+		std::string output;
+		std::chrono::steady_clock::time_point submitted;
+	};
+
+	/**
+	 * @brief Parses job line, empty lines and lines starting with '#' are not jobs.
+	 */
+	bool ParseJob(const std::string& line, Job& job);
+
+	/**
+	 * @class BatchServer
+	 * @brief Renders many small independent images concurrently, one job per core.
+	 *
+	 * Small images give tile parallelism too little work per frame, so the server parallelizes across jobs
+	 * instead: every worker thread takes whole jobs and renders them single threaded into color and depth
+	 * Buffers taken from pools sized for the largest allowed job. Jobs can be submitted while earlier ones are
+	 * rendering, each result line is streamed out as soon as its job completes.
+	 */
+	class BatchServer
+	{
+	protected:
+		std::vector<std::thread> mWorkers;
+		Renderer::BufferPool mColorPool;
+		Renderer::BufferPool mDepthPool;
+		uint32_t mMaxPixels;
+
+		std::mutex mMutex;
+		std::condition_variable mJobReady;
+		std::condition_variable mJobDone;
+		std::deque<Job> mJobs;
+		uint64_t mSubmitted;
+		uint64_t mCompleted;
+		uint64_t mFailed;
+		bool mExit;
+
+		std::ostream* mResults;
+		std::mutex mResultsMutex;
+		std::vector<double> mLatencies;
+		std::chrono::steady_clock::time_point mFirstSubmit;
+		std::chrono::steady_clock::time_point mLastComplete;
+
+		void WorkerLoop();
+		bool Render(const Job& job, Renderer::Buffer& color, Renderer::Buffer& depth);
+
+	public:
+		/**
+		 * @param results Stream receiving one line per finished job.
+		 * @param threads Worker count, 0 uses hardware concurrency.
+		 * @param maxPixels Largest width * height accepted, pool buffers are allocated for it up front.
+		 */
+		BatchServer(std::ostream& results, uint32_t threads = 0, uint32_t maxPixels = 1024 * 1024);
+		virtual ~BatchServer();
+
+		BatchServer(const BatchServer&) = delete;
+		BatchServer& operator=(const BatchServer&) = delete;
+
+		/**
+		 * @brief Queues job, returns immediately. Fails for jobs larger than maxPixels.
+		 */
+		bool Submit(Job job);
+
+		/**
+		 * @brief Waits until every submitted job has completed.
+		 */
+		void Finish();
+
+		/**
+		 * @brief Submits every job line of input and waits for completion.
+		 * @return Number of lines that were not valid jobs.
+		 */
+		uint32_t Run(std::istream& input);
+
+		/**
+		 * @brief Publishes batch.jobs, batch.failed, batch.jobsPerSecond (first submission to last completion) and
+		 * batch.latencyP50Ms, P90, P99 and Max over jobs completed so far, latency counts from submission.
+		 */
+		void PublishStatistics();
+	};
+}
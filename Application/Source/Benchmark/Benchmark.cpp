@@ -0,0 +1,576 @@
+#include "Benchmark.h"
+#include "../Renderer/Color.h"
+#include "../Renderer/CpuTopology.h"
+#include "../Renderer/MultisampleBuffer.h"
+#include "../Renderer/Profiler.h"
+#include "../Renderer/Rasterizer.h"
+#include "../Renderer/ShadowMap.h"
+#include "../Renderer/TileRenderer.h"
+#include "../Scene/Scene.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace
+{
+	/** @brief Counts every operator new of the process, lets benchmarks check steady state frames for heap allocations. */
+	std::atomic<uint64_t> HeapAllocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+	HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* memory = malloc(size ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	free(memory);
+}
+
+namespace Benchmark
+{
+	namespace
+	{
+		const uint32_t Width = 640;
+		const uint32_t Height = 480;
+		const int Iterations = 20;
+
+		/**
+		 * @brief Checkerboard from texture coordinates modulating vertex color.
+		 */
+		struct CheckerShader
+		{
+			Renderer::PacketFloat4 operator()(const Renderer::PixelPacket& packet) const
+			{
+				__m128i u = _mm_cvttps_epi32(_mm_mul_ps(packet.texcoord.x, _mm_set1_ps(32.0f)));
+				__m128i v = _mm_cvttps_epi32(_mm_mul_ps(packet.texcoord.y, _mm_set1_ps(32.0f)));
+				__m128 parity = _mm_cvtepi32_ps(_mm_and_si128(_mm_xor_si128(u, v), _mm_set1_epi32(1)));
+				__m128 factor = _mm_add_ps(_mm_set1_ps(0.5f), _mm_mul_ps(parity, _mm_set1_ps(0.5f)));
+
+				Renderer::PacketFloat4 result;
+				result.x = _mm_mul_ps(packet.color.x, factor);
+				result.y = _mm_mul_ps(packet.color.y, factor);
+				result.z = _mm_mul_ps(packet.color.z, factor);
+				result.w = packet.color.w;
+				return result;
+			}
+		};
+
+		/**
+		 * @brief Renders scene Iterations times, returns average milliseconds per frame.
+		 */
+		template<typename Shader>
+		double RenderScene(Renderer::Rasterizer& rasterizer, Renderer::Buffer& color, Renderer::Buffer& depth, const Scenes::Scene& scene, const Shader& shader)
+		{
+			uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				color.Fill(&clearColor);
+				depth.Fill(&scene.clearDepth);
+				rasterizer.DrawTriangles(scene.vertices.data(), nullptr, (uint32_t)(scene.vertices.size() / 3), shader);
+			}
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+		}
+
+		double RenderScene(Renderer::Rasterizer& rasterizer, Renderer::Buffer& color, Renderer::Buffer& depth, const Scenes::Scene& scene)
+		{
+			return RenderScene(rasterizer, color, depth, scene, Renderer::VertexColorShader());
+		}
+
+		/**
+		 * @brief Renders scene through tile renderer Iterations times, returns average milliseconds per frame.
+		 */
+		double RenderTiled(Renderer::TileRenderer& tileRenderer, Renderer::Buffer& color, const Scenes::Scene& scene, Renderer::TileRenderer::Topology topology)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, color, nullptr, topology);
+			}
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+		}
+	}
+
+	bool Run(const std::string& name)
+	{
+		if (name == "small-triangles")
+		{
+			SmallTriangles();
+			return true;
+		}
+
+		if (name == "tiles")
+		{
+			TileRendering();
+			return true;
+		}
+
+		if (name == "shaders")
+		{
+			Shaders();
+			return true;
+		}
+
+		if (name == "queue")
+		{
+			SubmissionQueue();
+			return true;
+		}
+
+		if (name == "shadows")
+		{
+			Shadows();
+			return true;
+		}
+
+		if (name == "wireframe")
+		{
+			Wireframe();
+			return true;
+		}
+
+		if (name == "transparency")
+		{
+			Transparency();
+			return true;
+		}
+
+		if (name == "msaa")
+		{
+			Multisampling();
+			return true;
+		}
+
+		if (name == "numa")
+		{
+			NumaPinning();
+			return true;
+		}
+
+		return false;
+	}
+
+	void SmallTriangles()
+	{
+		Renderer::Buffer color(4, Width * Height);
+		Renderer::Buffer depth(4, Width * Height);
+		Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+
+		Scenes::Scene scene;
+		Scenes::Create("micro", Width, Height, scene);
+
+		rasterizer.SetSmallTrianglePath(false);
+		double general = RenderScene(rasterizer, color, depth, scene);
+
+		rasterizer.SetSmallTrianglePath(true);
+		rasterizer.ResetStatistics();
+		double small = RenderScene(rasterizer, color, depth, scene);
+		rasterizer.PublishStatistics();
+
+		std::cout << "triangles = " << scene.vertices.size() / 3 << std::endl;
+		std::cout << "general path = " << general << " ms" << std::endl;
+		std::cout << "small path = " << small << " ms (" << general / small << "x)" << std::endl;
+		Renderer::Profiler::Get().Report(std::cout);
+	}
+
+	void TileRendering()
+	{
+		const uint32_t width = 1920;
+		const uint32_t height = 1080;
+
+		Renderer::Buffer immediateColor(4, width * height);
+		Renderer::Buffer immediateDepth(4, width * height);
+		Renderer::Buffer tiledColor(4, width * height);
+		Renderer::Rasterizer rasterizer(&immediateColor, &immediateDepth, width, height);
+		Renderer::ThreadPool pool;
+		Renderer::TileRenderer tileRenderer(width, height, &pool);
+
+		Scenes::Scene scene;
+		Scenes::CreateRandomTriangles(scene, width, height, 200, 1);
+
+		double immediate = RenderScene(rasterizer, immediateColor, immediateDepth, scene);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, tiledColor, nullptr);
+		}
+		double tiled = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+		// Working set is known after the frames above, from now on a frame must not touch the heap
+		uint64_t allocations = HeapAllocations.load();
+		for (int i = 0; i < Iterations; i++)
+		{
+			tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, tiledColor, nullptr);
+		}
+		allocations = HeapAllocations.load() - allocations;
+
+		std::cout << "threads = " << pool.GetThreadCount() << std::endl;
+		std::cout << "immediate = " << immediate << " ms" << std::endl;
+		std::cout << "tiled = " << tiled << " ms (" << immediate / tiled << "x)" << std::endl;
+		std::cout << "identical = " << (memcmp(immediateColor.GetData(), tiledColor.GetData(), immediateColor.GetSize()) == 0 ? "yes" : "no") << std::endl;
+		std::cout << "steady state heap allocations = " << (double)allocations / Iterations << " per frame" << std::endl;
+		Renderer::Profiler::Get().Report(std::cout);
+	}
+
+	void Shaders()
+	{
+		Renderer::Buffer color(4, Width * Height);
+		Renderer::Buffer depth(4, Width * Height);
+		Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+
+		Scenes::Scene scene;
+		Scenes::CreateRandomTriangles(scene, Width, Height, 256, 1);
+
+		Renderer::DynamicPixelShader dynamic = CheckerShader();
+		double erased = RenderScene(rasterizer, color, depth, scene, dynamic);
+		double inlined = RenderScene(rasterizer, color, depth, scene, CheckerShader());
+
+		std::cout << "std::function shader = " << erased << " ms" << std::endl;
+		std::cout << "inlined shader = " << inlined << " ms (" << erased / inlined << "x)" << std::endl;
+	}
+
+	void SubmissionQueue()
+	{
+		const uint32_t producerCount = 4;
+		const uint32_t batchTriangles = 1024;
+
+		Renderer::Buffer serialColor(4, Width * Height);
+		Renderer::Buffer queuedColor(4, Width * Height);
+		Renderer::ThreadPool pool;
+		Renderer::ThreadPool producers(producerCount);
+		Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+
+		Scenes::Scene scene;
+		Scenes::Create("micro", Width, Height, scene);
+		std::vector<Renderer::Vertex> transformed(scene.vertices.size());
+		uint32_t triangleCount = (uint32_t)(scene.vertices.size() / 3);
+		uint32_t batchCount = (triangleCount + batchTriangles - 1) / batchTriangles;
+
+		// Stands in for vertex processing, slight rotation around the screen center
+		auto transform = [&](uint32_t batch)
+		{
+			size_t first = (size_t)batch * batchTriangles * 3;
+			size_t end = std::min(first + batchTriangles * 3, scene.vertices.size());
+			const float c = 0.9998f;
+			const float s = 0.02f;
+			for (size_t i = first; i < end; i++)
+			{
+				Renderer::Vertex v = scene.vertices[i];
+				float x = v.position.x - Width * 0.5f;
+				float y = v.position.y - Height * 0.5f;
+				v.position.x = x * c - y * s + Width * 0.5f;
+				v.position.y = x * s + y * c + Height * 0.5f;
+				transformed[i] = v;
+			}
+			return (uint32_t)(end - first);
+		};
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			for (uint32_t b = 0; b < batchCount; b++)
+			{
+				transform(b);
+			}
+			tileRenderer.Render(transformed, scene.clearColor, scene.clearDepth, serialColor, nullptr);
+		}
+		double serial = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			tileRenderer.BeginFrame();
+			producers.ParallelFor(batchCount, [&](uint32_t batch, uint32_t)
+			{
+				uint32_t count = transform(batch);
+				tileRenderer.Submit(&transformed[(size_t)batch * batchTriangles * 3], count, batch);
+			});
+			tileRenderer.EndFrame(scene.clearColor, scene.clearDepth, queuedColor, nullptr);
+		}
+		double queued = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+		std::cout << "batches = " << batchCount << " x " << batchTriangles << " triangles, producers = " << producers.GetThreadCount() << std::endl;
+		std::cout << "transform then render = " << serial << " ms" << std::endl;
+		std::cout << "queued = " << queued << " ms (" << serial / queued << "x)" << std::endl;
+		std::cout << "identical = " << (memcmp(serialColor.GetData(), queuedColor.GetData(), serialColor.GetSize()) == 0 ? "yes" : "no") << std::endl;
+		Renderer::Profiler::Get().Report(std::cout);
+	}
+
+	void Shadows()
+	{
+		Renderer::Buffer color(4, Width * Height);
+		Renderer::Buffer depth(4, Width * Height);
+		Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+
+		const char* scenes[] = { "micro", "triangles" };
+		for (const char* name : scenes)
+		{
+			Scenes::Scene scene;
+			Scenes::Create(name, Width, Height, scene);
+
+			double full = RenderScene(rasterizer, color, depth, scene);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				depth.Fill(&scene.clearDepth);
+				rasterizer.DrawTrianglesDepth(scene.vertices.data(), nullptr, (uint32_t)(scene.vertices.size() / 3));
+			}
+			double depthOnly = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+			std::cout << name << ": full = " << full << " ms, depth only = " << depthOnly << " ms (" << full / depthOnly << "x)" << std::endl;
+		}
+
+		// Light from upper left, map resolution about twice the screen so texels stay near pixel size
+		Scenes::Scene scene;
+		Scenes::CreateRandomTriangles(scene, Width, Height, 64, 1);
+		Renderer::ShadowMap shadowMap(1024);
+		shadowMap.SetLight(0.6f, -0.5f, Width, Height, 200.0f);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			shadowMap.Render(scene.vertices);
+		}
+		double shadowPass = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+		double shadowed = RenderScene(rasterizer, color, depth, scene, Renderer::ShadowShader(shadowMap));
+		double unshadowed = RenderScene(rasterizer, color, depth, scene);
+
+		std::cout << "shadow map 1024x1024 = " << shadowPass << " ms per cascade" << std::endl;
+		std::cout << "main pass = " << unshadowed << " ms, with PCF = " << shadowed << " ms" << std::endl;
+		Renderer::Profiler::Get().Report(std::cout);
+	}
+
+	void Wireframe()
+	{
+		const uint32_t width = 1920;
+		const uint32_t height = 1080;
+		typedef Renderer::TileRenderer::Topology Topology;
+
+		Renderer::Buffer immediateColor(4, width * height);
+		Renderer::Buffer immediateDepth(4, width * height);
+		Renderer::Buffer tiledColor(4, width * height);
+		Renderer::Rasterizer rasterizer(&immediateColor, &immediateDepth, width, height);
+		Renderer::ThreadPool pool;
+		Renderer::TileRenderer tileRenderer(width, height, &pool);
+
+		// Tessellated meshes with 2 and 8 pixel cells, then few large overlapping triangles
+		const char* names[] = { "mesh 2px", "mesh 8px", "triangles" };
+		for (int s = 0; s < 3; s++)
+		{
+			const char* name = names[s];
+			Scenes::Scene filled;
+			if (s < 2)
+			{
+				Scenes::CreateMicroTriangles(filled, width, height, s == 0 ? 2.0f : 8.0f, 1);
+			}
+			else
+			{
+				Scenes::Create("triangles", width, height, filled);
+			}
+			Scenes::Scene wireframe;
+			Scenes::CreateWireframe(filled, wireframe);
+
+			double filledTime = RenderTiled(tileRenderer, tiledColor, filled, Topology::Triangles);
+			double wireTime = RenderTiled(tileRenderer, tiledColor, wireframe, Topology::Lines);
+
+			// Same lines drawn immediately must match tiles pixel for pixel
+			uint32_t clearColor = Renderer::PackColor(wireframe.clearColor);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				immediateColor.Fill(&clearColor);
+				immediateDepth.Fill(&wireframe.clearDepth);
+				rasterizer.DrawLines(wireframe.vertices.data(), nullptr, (uint32_t)(wireframe.vertices.size() / 2));
+			}
+			double immediate = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+			bool identical = memcmp(immediateColor.GetData(), tiledColor.GetData(), immediateColor.GetSize()) == 0;
+
+			tileRenderer.SetLineAntialiasing(true);
+			double antialiased = RenderTiled(tileRenderer, tiledColor, wireframe, Topology::Lines);
+			tileRenderer.SetLineAntialiasing(false);
+
+			tileRenderer.SetPointSize(3.0f);
+			double points = RenderTiled(tileRenderer, tiledColor, filled, Topology::Points);
+
+			std::cout << name << ": triangles = " << filled.vertices.size() / 3 << ", lines = " << wireframe.vertices.size() / 2 << std::endl;
+			std::cout << "  filled tiled = " << filledTime << " ms, wireframe tiled = " << wireTime << " ms (" << filledTime / wireTime << "x)" << std::endl;
+			std::cout << "  wireframe immediate = " << immediate << " ms, identical = " << (identical ? "yes" : "no") << std::endl;
+			std::cout << "  antialiased wireframe tiled = " << antialiased << " ms, 3px points tiled = " << points << " ms" << std::endl;
+		}
+		Renderer::Profiler::Get().Report(std::cout);
+	}
+
+	void Transparency()
+	{
+		const uint32_t width = 1920;
+		const uint32_t height = 1080;
+
+		Renderer::Buffer reference(4, width * height);
+		Renderer::Buffer tiledColor(4, width * height);
+		Renderer::ThreadPool pool;
+		Renderer::TileRenderer tileRenderer(width, height, &pool);
+		Renderer::Profiler& profiler = Renderer::Profiler::Get();
+
+		Scenes::Scene opaque;
+		Scenes::CreateRandomTriangles(opaque, width, height, 200, 1);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < Iterations; i++)
+		{
+			tileRenderer.Render(opaque.vertices, opaque.clearColor, opaque.clearDepth, tiledColor, nullptr);
+		}
+		double opaqueTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+		std::cout << "threads = " << pool.GetThreadCount() << ", opaque only = " << opaqueTime << " ms" << std::endl;
+
+		const uint32_t counts[] = { 16, 64, 256 };
+		const uint32_t budgets[] = { 1, 2, 4 };
+		for (uint32_t count : counts)
+		{
+			Scenes::Scene transparent;
+			Scenes::CreateTransparentTriangles(transparent, width, height, count, 2);
+
+			// Reference keeps MaxLayers fragments in every pixel, nothing is merged below that depth complexity
+			tileRenderer.SetTransparencyBudget(Renderer::FragmentBuffer::MaxLayers);
+			tileRenderer.Render(opaque.vertices, transparent.vertices, opaque.clearColor, opaque.clearDepth, reference, nullptr);
+			std::cout << "transparent triangles = " << count << ", fragments = " << profiler.GetValue("oit.fragments") << std::endl;
+
+			for (uint32_t budget : budgets)
+			{
+				tileRenderer.SetTransparencyBudget(budget);
+				start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < Iterations; i++)
+				{
+					tileRenderer.Render(opaque.vertices, transparent.vertices, opaque.clearColor, opaque.clearDepth, tiledColor, nullptr);
+				}
+				double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+				const uint32_t* a = (const uint32_t*)reference.GetData();
+				const uint32_t* b = (const uint32_t*)tiledColor.GetData();
+				uint32_t differing = 0;
+				for (uint32_t i = 0; i < width * height; i++)
+				{
+					differing += a[i] != b[i];
+				}
+
+				std::cout << "  budget " << budget << "/px: " << time << " ms, pool = " << profiler.GetValue("oit.poolBytes") / (1024.0 * 1024.0)
+					<< " MB, merged = " << profiler.GetValue("oit.merged") << ", differing pixels = " << differing << std::endl;
+			}
+		}
+		profiler.Report(std::cout);
+	}
+
+	void Multisampling()
+	{
+		Renderer::Buffer color(4, Width * Height);
+		Renderer::Buffer depth(4, Width * Height);
+		Renderer::Buffer resolved(4, Width * Height);
+		Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+
+		// Few large triangles keep most tiles compressed, micro triangles put edges into every tile
+		const char* names[] = { "triangles", "micro" };
+		const uint32_t sampleCounts[] = { 1, 4, 8 };
+		for (const char* name : names)
+		{
+			Scenes::Scene scene;
+			Scenes::Create(name, Width, Height, scene);
+			uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+			std::cout << name << ": triangles = " << scene.vertices.size() / 3 << ", without MSAA = " << RenderScene(rasterizer, color, depth, scene) << " ms" << std::endl;
+
+			for (uint32_t samples : sampleCounts)
+			{
+				Renderer::MultisampleBuffer target(Width, Height, samples);
+				Renderer::Rasterizer multisampled(nullptr, nullptr, Width, Height);
+				multisampled.SetMultisampleBuffer(&target);
+
+				// Clear, rasterize and resolve, a whole multisampled frame
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < Iterations; i++)
+				{
+					target.Clear(clearColor, scene.clearDepth);
+					multisampled.DrawTriangles(scene.vertices.data(), nullptr, (uint32_t)(scene.vertices.size() / 3));
+					target.Resolve(resolved);
+				}
+				double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+
+				std::cout << "  " << samples << "x = " << time << " ms, bytes = " << target.GetMemoryFootprint() << ", expanded tiles = "
+					<< target.GetExpandedTileCount() << " / " << target.GetGrid().GetTileCount() << std::endl;
+			}
+		}
+	}
+
+	void NumaPinning()
+	{
+		const uint32_t width = 1920;
+		const uint32_t height = 1080;
+
+		Renderer::CpuTopology topology = Renderer::CpuTopology::Detect();
+		topology.Report(std::cout);
+
+		Scenes::Scene scene;
+		Scenes::CreateRandomTriangles(scene, width, height, 200, 1);
+		Renderer::Profiler& profiler = Renderer::Profiler::Get();
+
+		// Fresh pool and targets per run, first touch decides where target pages live
+		Renderer::Buffer reference(4, width * height);
+		for (int pinned = 0; pinned < 2; pinned++)
+		{
+			Renderer::ThreadPool pool;
+			bool placed = pinned && pool.Pin(topology);
+			Renderer::TileRenderer tileRenderer(width, height, &pool);
+			Renderer::Buffer color(4, width * height);
+			Renderer::Buffer depth(4, width * height);
+			tileRenderer.SetDiscardDepth(false);
+			if (placed)
+			{
+				tileRenderer.PlaceTargets(color, &depth);
+			}
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < Iterations; i++)
+			{
+				tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, color, &depth);
+			}
+			double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Iterations;
+			std::cout << (pinned ? "pinned" : "unpinned") << ": threads = " << pool.GetThreadCount() << ", " << time << " ms";
+			if (pinned && !placed)
+			{
+				std::cout << " (pinning unavailable)";
+			}
+			std::cout << ", stolen tiles = " << profiler.GetValue("numa.stolenTiles");
+			for (uint32_t n = 0; n < pool.GetNodeCount(); n++)
+			{
+				std::cout << ", node " << n << " = " << profiler.GetValue("numa.node" + std::to_string(n) + ".writeGBs") << " GB/s";
+			}
+			std::cout << std::endl;
+
+			if (pinned)
+			{
+				std::cout << "identical = " << (memcmp(reference.GetData(), color.GetData(), color.GetSize()) == 0 ? "yes" : "no") << std::endl;
+			}
+			else
+			{
+				memcpy(reference.GetData(), color.GetData(), color.GetSize());
+			}
+		}
+		profiler.Report(std::cout);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+namespace Benchmark
+{
+	/**
+	 * @brief Runs named headless benchmark and prints results to standard output.
+	 * @return False if name is unknown.
+	 */
+	bool Run(const std::string& name);
+
+	/**
+	 * @brief Micro-triangle scene with small triangle path enabled and disabled.
+	 */
+	void SmallTriangles();
+
+	/**
+	 * @brief Full HD scene rendered immediately into frame buffer and through tile local buffers.
+	 */
+	void TileRendering();
+
+	/**
+	 * @brief Same pixel shader compiled into raster loop and called through std::function.
+	 */
+	void Shaders();
+
+	/**
+	 * @brief Producers transforming and submitting batches through the queue versus transform then render.
+	 */
+	void SubmissionQueue();
+
+	/**
+	 * @brief Batched depth-only kernel against batched full raster kernel, then shadow map plus PCF main pass.
+	 */
+	void Shadows();
+
+	/**
+	 * @brief Filled scenes against their wireframes and vertex points, immediate and tiled.
+	 */
+	void Wireframe();
+
+	/**
+	 * @brief Order-independent transparency over opaque scene with growing layer counts and pool budgets.
+	 */
+	void Transparency();
+
+	/**
+	 * @brief Scenes rasterized into 1x, 4x and 8x multisampled targets, frame time and memory footprint.
+	 */
+	void Multisampling();
+
+	/**
+	 * @brief CPU topology, then tiled frames with free threads against pinned threads and node local targets.
+	 */
+	void NumaPinning();
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "Replay.h"
+#include "../Renderer/Color.h"
+#include "../Renderer/FragmentBuffer.h"
+#include "../Renderer/FrameCapture.h"
+#include "../Renderer/Profiler.h"
+#include "../Renderer/Rasterizer.h"
+#include "../Renderer/TileRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+namespace Capture
+{
+	using Math::Numeric::float4;
+	typedef Renderer::TileRenderer::Topology Topology;
+
+	namespace
+	{
+		/**
+		 * @brief FNV-1a over the color target.
+		 */
+		uint64_t Checksum(const Renderer::Buffer& buffer)
+		{
+			const uint8_t* data = (const uint8_t*)buffer.GetData();
+			uint64_t hash = 14695981039346656037ull;
+			for (uint32_t i = 0; i < buffer.GetSize(); i++)
+			{
+				hash = (hash ^ data[i]) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+		void Draw(Renderer::Rasterizer& rasterizer, const std::vector<Renderer::Vertex>& vertices, Topology topology)
+		{
+			switch (topology)
+			{
+			case Topology::Triangles:
+				for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+				{
+					rasterizer.DrawTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+				}
+				break;
+			case Topology::Lines:
+				for (size_t i = 0; i + 1 < vertices.size(); i += 2)
+				{
+					rasterizer.DrawLine(vertices[i], vertices[i + 1]);
+				}
+				break;
+			case Topology::Points:
+				for (const Renderer::Vertex& v : vertices)
+				{
+					rasterizer.DrawPoint(v);
+				}
+				break;
+			}
+		}
+
+		/**
+		 * @brief Renders capture iterations times through a single rasterizer, like the frame without tiles.
+		 */
+		void RenderImmediate(const Renderer::FrameCapture& capture, bool smallTrianglePath, uint32_t iterations, Renderer::Buffer& color,
+			std::vector<double>& times)
+		{
+			const Renderer::CaptureState& state = capture.state;
+			Renderer::Buffer depth(sizeof(float), state.width * state.height);
+			Renderer::Rasterizer rasterizer(&color, &depth, state.width, state.height);
+			rasterizer.SetSmallTrianglePath(smallTrianglePath);
+			rasterizer.SetLineAntialiasing((state.flags & Renderer::CaptureState::LineAntialiasing) != 0);
+			rasterizer.SetPointSize(state.pointSize);
+
+			std::unique_ptr<Renderer::FragmentBuffer> fragments;
+			if (!capture.transparent.empty())
+			{
+				// Budget is an average over the frame, a pixel never holds more than MaxLayers
+				uint32_t layers = std::min(std::max(state.transparencyBudget, 1u), (uint32_t)Renderer::FragmentBuffer::MaxLayers) - 1;
+				fragments.reset(new Renderer::FragmentBuffer(state.width, state.height, state.width * state.height * layers));
+			}
+
+			float4 clearColor(state.clearColor[0], state.clearColor[1], state.clearColor[2], state.clearColor[3]);
+			uint32_t packedClear = Renderer::PackColor(clearColor);
+			const void* clear = color.GetElementSize() == sizeof(float4) ? (const void*)&clearColor : (const void*)&packedClear;
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				rasterizer.ResetStatistics();
+				color.Fill(clear);
+				depth.Fill(&state.clearDepth);
+				Draw(rasterizer, capture.opaque, (Topology)state.topology);
+				if (fragments)
+				{
+					fragments->Clear();
+					rasterizer.SetFragmentBuffer(fragments.get());
+					Draw(rasterizer, capture.transparent, Topology::Triangles);
+					rasterizer.SetFragmentBuffer(nullptr);
+					fragments->Resolve(color);
+				}
+				times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+			rasterizer.PublishStatistics();
+		}
+
+		void RenderTiled(const Renderer::FrameCapture& capture, uint32_t threads, uint32_t iterations, Renderer::Buffer& color, std::vector<double>& times)
+		{
+			const Renderer::CaptureState& state = capture.state;
+			Renderer::ThreadPool pool(threads);
+			Renderer::TileRenderer tileRenderer(state.width, state.height, &pool, state.tileSize);
+			tileRenderer.SetDiscardDepth((state.flags & Renderer::CaptureState::DiscardDepth) != 0);
+			tileRenderer.SetLineAntialiasing((state.flags & Renderer::CaptureState::LineAntialiasing) != 0);
+			tileRenderer.SetPointSize(state.pointSize);
+			tileRenderer.SetTransparencyBudget(state.transparencyBudget);
+
+			// Depth target only matters when the frame kept it
+			Renderer::Buffer depth(sizeof(float), state.width * state.height);
+			float4 clearColor(state.clearColor[0], state.clearColor[1], state.clearColor[2], state.clearColor[3]);
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				if (capture.transparent.empty())
+				{
+					tileRenderer.Render(capture.opaque, clearColor, state.clearDepth, color, &depth, (Topology)state.topology);
+				}
+				else
+				{
+					tileRenderer.Render(capture.opaque, capture.transparent, clearColor, state.clearDepth, color, &depth);
+				}
+				times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+		}
+	}
+
+	bool ParseThreadList(const std::string& text, std::vector<uint32_t>& threads)
+	{
+		std::istringstream stream(text);
+		std::string token;
+		threads.clear();
+		while (std::getline(stream, token, ','))
+		{
+			int count = atoi(token.c_str());
+			if (count <= 0)
+			{
+				return false;
+			}
+			threads.push_back((uint32_t)count);
+		}
+		return !threads.empty();
+	}
+
+	bool Replay(const std::string& path, const ReplaySettings& settings, std::ostream& out)
+	{
+		bool tiled = settings.variant.empty() || settings.variant == "tiled";
+		if (!tiled && settings.variant != "immediate" && settings.variant != "general")
+		{
+			out << "unknown variant " << settings.variant << std::endl;
+			return false;
+		}
+
+		Renderer::FrameCapture capture;
+		auto start = std::chrono::high_resolution_clock::now();
+		if (!capture.Load(path))
+		{
+			out << "cannot load capture " << path << std::endl;
+			return false;
+		}
+		double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		const Renderer::CaptureState& state = capture.state;
+		const char* topologies[] = { "triangles", "lines", "points" };
+		out << "capture = " << path << " (" << capture.GetFileSize() << " bytes, loaded in " << loadMs << " ms)" << std::endl;
+		out << "frame = " << state.width << "x" << state.height << " " << (state.colorElementSize == 16 ? "float4" : "rgba8")
+			<< ", tile = " << state.tileSize << ", " << topologies[std::min(state.topology, 2u)] << " = " << capture.opaque.size()
+			<< " vertices, transparent = " << capture.transparent.size() << " vertices" << std::endl;
+
+		// Thread count is meaningless for the single rasterizer variants, they run once
+		std::vector<uint32_t> threads = settings.threads;
+		if (threads.empty() || !tiled)
+		{
+			threads.assign(1, tiled ? 0 : 1);
+		}
+
+		uint32_t iterations = std::max(settings.iterations, 1u);
+		Renderer::Buffer color(state.colorElementSize == 16 ? 16 : 4, state.width * state.height);
+		for (uint32_t count : threads)
+		{
+			std::vector<double> times;
+			if (tiled)
+			{
+				RenderTiled(capture, count, iterations, color, times);
+			}
+			else
+			{
+				RenderImmediate(capture, settings.variant == "immediate", iterations, color, times);
+			}
+
+			double total = 0.0;
+			for (double time : times)
+			{
+				total += time;
+			}
+
+			out << (tiled ? "tiled" : settings.variant);
+			if (tiled)
+			{
+				out << " threads = " << (count ? std::to_string(count) : std::string("auto"));
+			}
+			out << ": average = " << total / times.size() << " ms, fastest = " << *std::min_element(times.begin(), times.end())
+				<< " ms, checksum = " << std::hex << std::setw(16) << std::setfill('0') << Checksum(color) << std::dec << std::setfill(' ') << std::endl;
+		}
+
+		Renderer::Profiler::Get().Report(out);
+		return true;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Capture
+{
+	/**
+	 * @struct ReplaySettings
+	 * @brief How a captured frame is re-rendered, see Replay.
+	 */
+	struct ReplaySettings
+	{
+		/** @brief "tiled" (TileRenderer), "immediate" (one Rasterizer) or "general" (immediate, small triangle path off). */
+		std::string variant;
+		/** @brief Tiled worker counts, one run each, empty runs once with one thread per core. */
+		std::vector<uint32_t> threads;
+		uint32_t iterations;
+	};
+
+	/**
+	 * @brief Parses comma separated thread counts like "1,2,4".
+	 */
+	bool ParseThreadList(const std::string& text, std::vector<uint32_t>& threads);
+
+	/**
+	 * @brief Loads capture written by Renderer::FrameCapture::Save and renders it headless.
+	 *
+	 * Every run prints average and fastest frame time and a checksum of the final color target, so A/B runs of
+	 * two builds or variants show at once whether output changed. Profiler counters of the last frame follow.
+	 * @return False if capture cannot be loaded or variant is unknown.
+	 */
+	bool Replay(const std::string& path, const ReplaySettings& settings, std::ostream& out);
+}
@@ -0,0 +1,216 @@
+#include "Encoders.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Export
+{
+	namespace
+	{
+		void Append(std::vector<uint8_t>& output, const char* text)
+		{
+			output.insert(output.end(), text, text + strlen(text));
+		}
+
+		void AppendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+		{
+			output.push_back((uint8_t)(value >> 24));
+			output.push_back((uint8_t)(value >> 16));
+			output.push_back((uint8_t)(value >> 8));
+			output.push_back((uint8_t)value);
+		}
+
+		uint8_t Clamp(int value)
+		{
+			return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+		}
+	}
+
+	void EncodeRaw(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output)
+	{
+		const uint8_t* bytes = (const uint8_t*)pixels;
+		output.insert(output.end(), bytes, bytes + (size_t)width * height * 4);
+	}
+
+	void EncodePPM(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output)
+	{
+		char header[64];
+		snprintf(header, sizeof(header), "P6\n%u %u\n255\n", width, height);
+		Append(output, header);
+
+		size_t offset = output.size();
+		size_t count = (size_t)width * height;
+		output.resize(offset + count * 3);
+		uint8_t* destination = output.data() + offset;
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t pixel = pixels[i];
+			destination[i * 3] = (uint8_t)pixel;
+			destination[i * 3 + 1] = (uint8_t)(pixel >> 8);
+			destination[i * 3 + 2] = (uint8_t)(pixel >> 16);
+		}
+	}
+
+	void EncodeQOI(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output)
+	{
+		const uint8_t OpIndex = 0x00;
+		const uint8_t OpDiff = 0x40;
+		const uint8_t OpLuma = 0x80;
+		const uint8_t OpRun = 0xc0;
+		const uint8_t OpRGB = 0xfe;
+		const uint8_t OpRGBA = 0xff;
+
+		Append(output, "qoif");
+		AppendBigEndian(output, width);
+		AppendBigEndian(output, height);
+		output.push_back(4);
+		output.push_back(0);
+
+		// Worst case is 5 bytes per pixel, reserve once and write through a pointer
+		size_t count = (size_t)width * height;
+		size_t offset = output.size();
+		output.resize(offset + count * 5 + 8);
+		uint8_t* out = output.data() + offset;
+
+		uint32_t index[64];
+		memset(index, 0, sizeof(index));
+		uint32_t previous = 0xff000000;
+		int run = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t pixel = pixels[i];
+			if (pixel == previous)
+			{
+				run++;
+				if (run == 62 || i + 1 == count)
+				{
+					*out++ = (uint8_t)(OpRun | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				*out++ = (uint8_t)(OpRun | (run - 1));
+				run = 0;
+			}
+
+			int r = pixel & 0xff;
+			int g = (pixel >> 8) & 0xff;
+			int b = (pixel >> 16) & 0xff;
+			int a = pixel >> 24;
+			int slot = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+
+			if (index[slot] == pixel)
+			{
+				*out++ = (uint8_t)(OpIndex | slot);
+			}
+			else
+			{
+				index[slot] = pixel;
+				if (a == (int)(previous >> 24))
+				{
+					// Channel differences wrap around like the reference implementation
+					int8_t dr = (int8_t)(r - (int)(previous & 0xff));
+					int8_t dg = (int8_t)(g - (int)((previous >> 8) & 0xff));
+					int8_t db = (int8_t)(b - (int)((previous >> 16) & 0xff));
+					int8_t drg = (int8_t)(dr - dg);
+					int8_t dbg = (int8_t)(db - dg);
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						*out++ = (uint8_t)(OpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+					}
+					else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+					{
+						*out++ = (uint8_t)(OpLuma | (dg + 32));
+						*out++ = (uint8_t)(((drg + 8) << 4) | (dbg + 8));
+					}
+					else
+					{
+						*out++ = OpRGB;
+						*out++ = (uint8_t)r;
+						*out++ = (uint8_t)g;
+						*out++ = (uint8_t)b;
+					}
+				}
+				else
+				{
+					*out++ = OpRGBA;
+					*out++ = (uint8_t)r;
+					*out++ = (uint8_t)g;
+					*out++ = (uint8_t)b;
+					*out++ = (uint8_t)a;
+				}
+			}
+			previous = pixel;
+		}
+
+		static const uint8_t End[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		memcpy(out, End, sizeof(End));
+		out += sizeof(End);
+		output.resize(out - output.data());
+	}
+
+	void EncodeY4MHeader(uint32_t width, uint32_t height, uint32_t frameRate, std::vector<uint8_t>& output)
+	{
+		char header[128];
+		snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, frameRate);
+		Append(output, header);
+	}
+
+	void EncodeY4MFrame(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output)
+	{
+		Append(output, "FRAME\n");
+
+		uint32_t chromaWidth = (width + 1) / 2;
+		uint32_t chromaHeight = (height + 1) / 2;
+		size_t offset = output.size();
+		output.resize(offset + (size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight);
+		uint8_t* y = output.data() + offset;
+		uint8_t* u = y + (size_t)width * height;
+		uint8_t* v = u + (size_t)chromaWidth * chromaHeight;
+
+		for (uint32_t row = 0; row < height; row++)
+		{
+			const uint32_t* source = pixels + (size_t)row * width;
+			for (uint32_t x = 0; x < width; x++)
+			{
+				int r = source[x] & 0xff;
+				int g = (source[x] >> 8) & 0xff;
+				int b = (source[x] >> 16) & 0xff;
+				y[(size_t)row * width + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+			}
+		}
+
+		// Odd sizes replicate last row / column
+		for (uint32_t cy = 0; cy < chromaHeight; cy++)
+		{
+			const uint32_t* row0 = pixels + (size_t)(cy * 2) * width;
+			const uint32_t* row1 = pixels + (size_t)std::min(cy * 2 + 1, height - 1) * width;
+			for (uint32_t cx = 0; cx < chromaWidth; cx++)
+			{
+				uint32_t x0 = cx * 2;
+				uint32_t x1 = std::min(x0 + 1, width - 1);
+				uint32_t quad[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+				int r = 0;
+				int g = 0;
+				int b = 0;
+				for (uint32_t pixel : quad)
+				{
+					r += pixel & 0xff;
+					g += (pixel >> 8) & 0xff;
+					b += (pixel >> 16) & 0xff;
+				}
+				r = (r + 2) >> 2;
+				g = (g + 2) >> 2;
+				b = (b + 2) >> 2;
+
+				u[(size_t)cy * chromaWidth + cx] = Clamp(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				v[(size_t)cy * chromaWidth + cx] = Clamp(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Export
+{
+	/**
+	 * Image encoders appending to a byte vector, which callers keep around so its capacity is reused.
+	 * Input pixels are RGBA8 as produced by Renderer::OutputStage (bytes R, G, B, A in memory), rows are
+	 * tightly packed.
+	 */
+
+	/**
+	 * @brief Appends pixels unchanged.
+	 */
+	void EncodeRaw(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output);
+
+	/**
+	 * @brief Appends binary PPM (P6) image, alpha is dropped.
+	 */
+	void EncodePPM(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output);
+
+	/**
+	 * @brief Appends QOI image (https://qoiformat.org), 4 channels, sRGB.
+	 */
+	void EncodeQOI(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output);
+
+	/**
+	 * @brief Appends YUV4MPEG2 stream header, 4:2:0 with centered chroma (C420jpeg).
+	 */
+	void EncodeY4MHeader(uint32_t width, uint32_t height, uint32_t frameRate, std::vector<uint8_t>& output);
+
+	/**
+	 * @brief Appends one Y4M frame, BT.601 studio range, chroma averaged over 2x2 pixels.
+	 */
+	void EncodeY4MFrame(const uint32_t* pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output);
+}
@@ -0,0 +1,288 @@
+#include "FrameExporter.h"
+#include "Encoders.h"
+#include "../Renderer/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace Export
+{
+	namespace
+	{
+		/**
+		 * @brief Splits path around its single "%u" or "%0Nu" frame number, any other '%' is rejected.
+		 */
+		bool ParseFramePattern(const std::string& path, std::string& prefix, uint32_t& digits, std::string& suffix)
+		{
+			size_t start = path.find('%');
+			size_t end = start + 1;
+			digits = 0;
+			if (end < path.size() && path[end] == '0')
+			{
+				while (++end < path.size() && path[end] >= '0' && path[end] <= '9')
+				{
+					digits = digits * 10 + (path[end] - '0');
+				}
+			}
+
+			if (end >= path.size() || path[end] != 'u' || digits > 20 || path.find('%', end) != std::string::npos)
+			{
+				return false;
+			}
+			prefix = path.substr(0, start);
+			suffix = path.substr(end + 1);
+			return true;
+		}
+	}
+
+	bool ParseFormat(const std::string& name, Format& format)
+	{
+		if (name == "raw")
+		{
+			format = Format::Raw;
+		}
+		else if (name == "ppm")
+		{
+			format = Format::PPM;
+		}
+		else if (name == "qoi")
+		{
+			format = Format::QOI;
+		}
+		else if (name == "y4m")
+		{
+			format = Format::Y4M;
+		}
+		else
+		{
+			return false;
+		}
+		return true;
+	}
+
+	FrameExporter::FrameExporter(uint32_t width, uint32_t height, const ExportSettings& settings)
+		: mWidth(width), mHeight(height), mSettings(settings), mValidPattern(false), mNameDigits(0), mStream(nullptr),
+		mPool(4, width * height, std::max(settings.bufferCount, 1u)),
+		mJobHead(0), mJobCount(0), mNextFrame(0), mNextWrite(0), mExit(false),
+		mDropped(0), mBytes(0), mEncodeMs(0.0), mFailed(false)
+	{
+		mPerFrameFiles = mSettings.path.find('%') != std::string::npos;
+		if (mPerFrameFiles)
+		{
+			mValidPattern = ParseFramePattern(mSettings.path, mNamePrefix, mNameDigits, mNameSuffix);
+			mFailed = !mValidPattern;
+		}
+		else
+		{
+			if (mSettings.path == "-")
+			{
+#ifdef _WIN32
+				_setmode(_fileno(stdout), _O_BINARY);
+#endif
+				mStream = stdout;
+			}
+			else
+			{
+				mStream = fopen(mSettings.path.c_str(), "wb");
+			}
+
+			if (!mStream)
+			{
+				mFailed = true;
+			}
+			else if (mSettings.format == Format::Y4M)
+			{
+				std::vector<uint8_t> header;
+				EncodeY4MHeader(mWidth, mHeight, mSettings.frameRate, header);
+				fwrite(header.data(), 1, header.size(), mStream);
+			}
+		}
+
+		mJobs.resize(mPool.GetCount());
+		for (uint32_t i = 0; i < std::max(mSettings.encoderThreads, 1u); i++)
+		{
+			mEncoders.push_back(std::thread(&FrameExporter::EncoderLoop, this));
+		}
+	}
+
+	FrameExporter::~FrameExporter()
+	{
+		Flush();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mExit = true;
+		}
+		mJobReady.notify_all();
+
+		for (std::thread& encoder : mEncoders)
+		{
+			encoder.join();
+		}
+
+		if (mStream && mStream != stdout)
+		{
+			fclose(mStream);
+		}
+	}
+
+	Renderer::Buffer* FrameExporter::Acquire()
+	{
+		if (mSettings.backpressure == Backpressure::Block)
+		{
+			return mPool.Acquire();
+		}
+
+		Renderer::Buffer* buffer = mPool.TryAcquire();
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mDropped++;
+		}
+		return buffer;
+	}
+
+	void FrameExporter::Submit(Renderer::Buffer* buffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			Job& job = mJobs[(mJobHead + mJobCount) % mJobs.size()];
+			job.buffer = buffer;
+			job.frame = mNextFrame++;
+			mJobCount++;
+		}
+		mJobReady.notify_one();
+	}
+
+	void FrameExporter::Flush()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWritten.wait(lock, [&]() { return mNextWrite == mNextFrame; });
+		}
+
+		if (mStream)
+		{
+			fflush(mStream);
+		}
+	}
+
+	void FrameExporter::EncoderLoop()
+	{
+		// Encoded frame memory is reused for the lifetime of the thread
+		std::vector<uint8_t> output;
+		for (;;)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mJobReady.wait(lock, [&]() { return mExit || mJobCount > 0; });
+				if (mJobCount == 0)
+				{
+					return;
+				}
+				job = mJobs[mJobHead];
+				mJobHead = (mJobHead + 1) % mJobs.size();
+				mJobCount--;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			output.clear();
+			Encode(*job.buffer, job.frame, output);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			// Pixels are no longer needed, renderer may reuse the buffer while this frame waits for its turn
+			mPool.Release(job.buffer);
+
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWritten.wait(lock, [&]() { return mNextWrite == job.frame; });
+			}
+
+			bool written = Write(job.frame, output);
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mEncodeMs += ms;
+				mBytes += output.size();
+				mFailed |= !written;
+				mNextWrite++;
+			}
+			mWritten.notify_all();
+		}
+	}
+
+	void FrameExporter::Encode(const Renderer::Buffer& buffer, uint64_t frame, std::vector<uint8_t>& output) const
+	{
+		(void)frame;
+		const uint32_t* pixels = (const uint32_t*)buffer.GetData();
+		switch (mSettings.format)
+		{
+		case Format::Raw:
+			EncodeRaw(pixels, mWidth, mHeight, output);
+			break;
+		case Format::PPM:
+			EncodePPM(pixels, mWidth, mHeight, output);
+			break;
+		case Format::QOI:
+			EncodeQOI(pixels, mWidth, mHeight, output);
+			break;
+		case Format::Y4M:
+			// A single frame file must be a valid stream on its own
+			if (mPerFrameFiles)
+			{
+				EncodeY4MHeader(mWidth, mHeight, mSettings.frameRate, output);
+			}
+			EncodeY4MFrame(pixels, mWidth, mHeight, output);
+			break;
+		}
+	}
+
+	bool FrameExporter::Write(uint64_t frame, const std::vector<uint8_t>& data)
+	{
+		if (!mPerFrameFiles)
+		{
+			return mStream && fwrite(data.data(), 1, data.size(), mStream) == data.size();
+		}
+
+		if (!mValidPattern)
+		{
+			return false;
+		}
+
+		// Frame number is inserted here, the user's path is never a format string
+		std::string number = std::to_string(frame);
+		if (number.size() < mNameDigits)
+		{
+			number.insert(0, mNameDigits - number.size(), '0');
+		}
+		FILE* file = fopen((mNamePrefix + number + mNameSuffix).c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+
+		bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+		return fclose(file) == 0 && written;
+	}
+
+	void FrameExporter::PublishStatistics()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Renderer::Profiler& profiler = Renderer::Profiler::Get();
+		profiler.Set("export.frames", (double)mNextWrite);
+		profiler.Set("export.dropped", (double)mDropped);
+		profiler.Set("export.bytes", (double)mBytes);
+		profiler.Set("export.encodeMs", mEncodeMs);
+		profiler.Set("export.stallMs", mPool.GetWaitMs());
+	}
+
+	bool FrameExporter::HasFailed()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mFailed;
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../Renderer/BufferPool.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Export
+{
+	enum class Format
+	{
+		Raw,
+		PPM,
+		QOI,
+		Y4M
+	};
+
+	/**
+	 * @brief What Acquire does when all frame buffers are in flight.
+	 */
+	enum class Backpressure
+	{
+		/** @brief Wait for an encoder to finish, render thread slows down to encoding speed. */
+		Block,
+		/** @brief Return null, caller skips the frame. */
+		Drop
+	};
+
+	/**
+	 * @brief Parses "raw", "ppm", "qoi" or "y4m".
+	 */
+	bool ParseFormat(const std::string& name, Format& format);
+
+	struct ExportSettings
+	{
+		Format format;
+		/**
+		 * @brief Path containing a frame number pattern, "%u" or zero padded "%0Nu" (e.g. "frame%05u.qoi"), writes
+		 * one file per frame, any other '%' fails the export. Any other path is a single stream of concatenated
+		 * frames, "-" is standard output.
+		 */
+		std::string path;
+		uint32_t frameRate;
+		uint32_t encoderThreads;
+		/** @brief RGBA8 frames in flight, bounds memory to bufferCount * width * height * 4 bytes. */
+		uint32_t bufferCount;
+		Backpressure backpressure;
+
+		ExportSettings() : format(Format::PPM), frameRate(30), encoderThreads(2), bufferCount(4), backpressure(Backpressure::Block) {}
+	};
+
+	/**
+	 * @class FrameExporter
+	 * @brief Asynchronous frame sequence writer, render thread never waits on encoding or disk.
+	 *
+	 * Render thread acquires an RGBA8 buffer from the pool, fills it (typically with Renderer::OutputStage) and
+	 * submits it. Encoder threads encode frames in parallel into per-thread byte vectors, then write them out
+	 * strictly in submission order and recycle the buffer.
+	 */
+	class FrameExporter
+	{
+	protected:
+		struct Job
+		{
+			Renderer::Buffer* buffer;
+			uint64_t frame;
+		};
+
+		uint32_t mWidth;
+		uint32_t mHeight;
+		ExportSettings mSettings;
+		bool mPerFrameFiles;
+		// Per-frame file name around the frame number
+		bool mValidPattern;
+		std::string mNamePrefix;
+		uint32_t mNameDigits;
+		std::string mNameSuffix;
+		FILE* mStream;
+
+		Renderer::BufferPool mPool;
+		std::vector<std::thread> mEncoders;
+
+		// Ring of submitted jobs, never holds more than the pool has buffers
+		std::vector<Job> mJobs;
+		size_t mJobHead;
+		size_t mJobCount;
+
+		std::mutex mMutex;
+		std::condition_variable mJobReady;
+		std::condition_variable mWritten;
+		uint64_t mNextFrame;
+		uint64_t mNextWrite;
+		bool mExit;
+
+		uint64_t mDropped;
+		uint64_t mBytes;
+		double mEncodeMs;
+		bool mFailed;
+
+		void EncoderLoop();
+		void Encode(const Renderer::Buffer& buffer, uint64_t frame, std::vector<uint8_t>& output) const;
+		bool Write(uint64_t frame, const std::vector<uint8_t>& data);
+
+	public:
+		FrameExporter(uint32_t width, uint32_t height, const ExportSettings& settings);
+		virtual ~FrameExporter();
+
+		FrameExporter(const FrameExporter&) = delete;
+		FrameExporter& operator=(const FrameExporter&) = delete;
+
+		/**
+		 * @brief Returns width * height RGBA8 buffer for the next frame, null if dropping under backpressure.
+		 */
+		Renderer::Buffer* Acquire();
+
+		/**
+		 * @brief Queues acquired buffer for encoding, frames are numbered in submission order.
+		 */
+		void Submit(Renderer::Buffer* buffer);
+
+		/**
+		 * @brief Waits until every submitted frame is written.
+		 */
+		void Flush();
+
+		/**
+		 * @brief Publishes export.frames, export.dropped, export.bytes, export.encodeMs and export.stallMs.
+		 */
+		void PublishStatistics();
+
+		bool HasFailed();
+	};
+}
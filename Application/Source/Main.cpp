@@ -1,26 +1,344 @@
 #include "Main.h"
+#include "Batch/BatchServer.h"
+#include "Capture/Replay.h"
+#include "Benchmark/Benchmark.h"
+#include "Export/FrameExporter.h"
 #include "Renderer/Buffer.h"
+#include "Renderer/DirtyTiles.h"
+#include "Renderer/FrameCapture.h"
+#include "Renderer/OutputStage.h"
+#include "Renderer/Profiler.h"
+#include "Renderer/Rasterizer.h"
+#include "Renderer/ResolutionController.h"
+#include "Renderer/ShadowMap.h"
+#include "Renderer/TileRenderer.h"
+#include "Renderer/Upscaler.h"
+#include "Scene/Scene.h"
+#include "Verify/GoldenImages.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
-int main()
+/**
+ * @brief Renders animated scene headless and writes every frame through FrameExporter.
+ */
+static int ExportFrames(const Export::ExportSettings& settings, uint32_t frameCount)
 {
-    sf::RenderWindow window(sf::VideoMode(1280, 960), "Renderer");
+    const uint32_t width = 640;
+    const uint32_t height = 480;
 
-    Renderer::Buffer buffer(4, 640 * 480);
-    buffer.Clear();
+    Renderer::ThreadPool pool;
+    Renderer::TileRenderer tileRenderer(width, height, &pool);
+    Renderer::OutputStage output(&pool);
+    Renderer::Buffer hdr(16, width * height);
+    Renderer::Rect rect = { 0, 0, width, height };
+
+    Scenes::Scene scene;
+    Scenes::Create("triangles", width, height, scene);
+    std::vector<Renderer::Vertex> vertices(scene.vertices.size());
+
+    Export::FrameExporter exporter(width, height, settings);
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        // Slow spin around the screen center so consecutive frames differ
+        float angle = frame * 0.01f;
+        float c = cosf(angle);
+        float s = sinf(angle);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            vertices[i] = scene.vertices[i];
+            float x = scene.vertices[i].position.x - width * 0.5f;
+            float y = scene.vertices[i].position.y - height * 0.5f;
+            vertices[i].position.x = x * c - y * s + width * 0.5f;
+            vertices[i].position.y = x * s + y * c + height * 0.5f;
+        }
+
+        tileRenderer.Render(vertices, scene.clearColor, scene.clearDepth, hdr, nullptr);
+
+        // Null under drop backpressure, frame is simply not exported
+        Renderer::Buffer* frameBuffer = exporter.Acquire();
+        if (frameBuffer)
+        {
+            output.Process(hdr, width, rect, frameBuffer->GetData(), width * 4);
+            exporter.Submit(frameBuffer);
+        }
+    }
+    exporter.Flush();
+
+    // Report on stderr, stdout may carry the stream
+    exporter.PublishStatistics();
+    Renderer::Profiler::Get().Report(std::cerr);
+    return exporter.HasFailed() ? 1 : 0;
+}
+
+/**
+ * @brief Renders one frame of named scene through TileRenderer and saves its input for Capture::Replay.
+ */
+static int CaptureFrame(const std::string& path, const std::string& sceneName, uint32_t transparentCount)
+{
+    const uint32_t width = 1920;
+    const uint32_t height = 1080;
+
+    Scenes::Scene scene;
+    if (!Scenes::Create(sceneName, width, height, scene))
+    {
+        std::cerr << "unknown scene " << sceneName << std::endl;
+        return 1;
+    }
+    Scenes::Scene transparent;
+    Scenes::CreateTransparentTriangles(transparent, width, height, transparentCount, 2);
+
+    Renderer::ThreadPool pool;
+    Renderer::TileRenderer tileRenderer(width, height, &pool);
+    Renderer::Buffer color(4, width * height);
+    Renderer::FrameCapture capture;
+    tileRenderer.CaptureNextFrame(&capture);
+    tileRenderer.Render(scene.vertices, transparent.vertices, scene.clearColor, scene.clearDepth, color, nullptr);
+
+    if (!capture.Save(path))
+    {
+        std::cerr << "cannot write " << path << std::endl;
+        return 1;
+    }
+    std::cout << "captured " << path << " (" << capture.GetFileSize() << " bytes)" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Pixel rectangle [x0, x1) x [y0, y1) a triangle may touch, edge pixels included.
+ */
+static void TriangleBounds(const Renderer::Vertex* v, int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = (int)floor(std::min(v[0].position.x, std::min(v[1].position.x, v[2].position.x)));
+    y0 = (int)floor(std::min(v[0].position.y, std::min(v[1].position.y, v[2].position.y)));
+    x1 = (int)ceil(std::max(v[0].position.x, std::max(v[1].position.x, v[2].position.x))) + 1;
+    y1 = (int)ceil(std::max(v[0].position.y, std::max(v[1].position.y, v[2].position.y))) + 1;
+}
+
+/**
+ * @brief Bins triangles by bounding box, first vertex indices of tile t are triangles[offsets[t], offsets[t + 1]).
+ */
+static void BinTriangles(const std::vector<Renderer::Vertex>& vertices, const Renderer::TileGrid& grid, std::vector<uint32_t>& offsets,
+    std::vector<uint32_t>& triangles)
+{
+    uint32_t tileSize = grid.GetTileSize();
+    offsets.assign(grid.GetTileCount() + 1, 0);
+    triangles.clear();
+
+    // First pass counts, second scatters, submission order is kept within every bin
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        {
+            int x0, y0, x1, y1;
+            TriangleBounds(&vertices[i], x0, y0, x1, y1);
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, (int)grid.GetWidth());
+            y1 = std::min(y1, (int)grid.GetHeight());
+            if (x0 >= x1 || y0 >= y1)
+            {
+                continue;
+            }
+
+            for (uint32_t ty = y0 / tileSize; ty <= (y1 - 1) / tileSize; ty++)
+            {
+                for (uint32_t tx = x0 / tileSize; tx <= (x1 - 1) / tileSize; tx++)
+                {
+                    uint32_t tile = ty * grid.GetTilesX() + tx;
+                    if (pass == 0)
+                    {
+                        offsets[tile + 1]++;
+                    }
+                    else
+                    {
+                        triangles[offsets[tile]++] = (uint32_t)i;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (uint32_t t = 0; t < grid.GetTileCount(); t++)
+            {
+                offsets[t + 1] += offsets[t];
+            }
+            triangles.resize(offsets.back());
+        }
+    }
+
+    // Scatter advanced every offset to the end of its bin, shift back so offsets[t] is the start again
+    for (uint32_t t = grid.GetTileCount(); t > 0; t--)
+    {
+        offsets[t] = offsets[t - 1];
+    }
+    offsets[0] = 0;
+}
+
+int main(int argc, char** argv)
+{
+    // Headless benchmarks, e.g. "Application --benchmark small-triangles"
+    if (argc > 2 && std::string(argv[1]) == "--benchmark")
+    {
+        if (!Benchmark::Run(argv[2]))
+        {
+            std::cout << "unknown benchmark " << argv[2] << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Golden image regression check, "Application --golden <directory> [--update]", exit code is failure count
+    if (argc > 2 && std::string(argv[1]) == "--golden")
+    {
+        bool update = argc > 3 && std::string(argv[3]) == "--update";
+        return (int)Verify::RunGoldenTests(argv[2], update, std::cout);
+    }
+
+    // Headless export, e.g. "Application --export frame%05u.qoi qoi 100" or "Application --export - y4m 600 | ffmpeg -i - out.mp4"
+    if (argc > 3 && std::string(argv[1]) == "--export")
+    {
+        Export::ExportSettings settings;
+        settings.path = argv[2];
+        if (!Export::ParseFormat(argv[3], settings.format))
+        {
+            std::cerr << "unknown format " << argv[3] << std::endl;
+            return 1;
+        }
+
+        uint32_t frameCount = argc > 4 ? (uint32_t)atoi(argv[4]) : 100;
+        for (int i = 5; i + 1 < argc; i += 2)
+        {
+            std::string option = argv[i];
+            if (option == "--threads")
+            {
+                settings.encoderThreads = (uint32_t)atoi(argv[i + 1]);
+            }
+            else if (option == "--buffers")
+            {
+                settings.bufferCount = (uint32_t)atoi(argv[i + 1]);
+            }
+            else if (option == "--backpressure")
+            {
+                settings.backpressure = std::string(argv[i + 1]) == "drop" ? Export::Backpressure::Drop : Export::Backpressure::Block;
+            }
+            else if (option == "--fps")
+            {
+                settings.frameRate = (uint32_t)atoi(argv[i + 1]);
+            }
+        }
+        return ExportFrames(settings, frameCount);
+    }
+
+    // Frame capture, "Application --capture frame.rcap [scene] [transparent triangles]"
+    if (argc > 2 && std::string(argv[1]) == "--capture")
+    {
+        std::string scene = argc > 3 ? argv[3] : "triangles";
+        uint32_t transparent = argc > 4 ? (uint32_t)atoi(argv[4]) : 0;
+        return CaptureFrame(argv[2], scene, transparent);
+    }
+
+    // Capture replay, e.g. "Application --replay frame.rcap --variant tiled --threads 1,2,4 --iterations 50"
+    if (argc > 2 && std::string(argv[1]) == "--replay")
+    {
+        Capture::ReplaySettings settings;
+        settings.iterations = 20;
+        for (int i = 3; i + 1 < argc; i += 2)
+        {
+            std::string option = argv[i];
+            if (option == "--variant")
+            {
+                settings.variant = argv[i + 1];
+            }
+            else if (option == "--threads" && !Capture::ParseThreadList(argv[i + 1], settings.threads))
+            {
+                std::cerr << "invalid thread list " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            else if (option == "--iterations")
+            {
+                settings.iterations = (uint32_t)atoi(argv[i + 1]);
+            }
+        }
+        return Capture::Replay(argv[2], settings, std::cout) ? 0 : 1;
+    }
+
+    // Batch render server, one job per line, e.g. "Application --batch jobs.txt" or "generator | Application --batch -"
+    if (argc > 2 && std::string(argv[1]) == "--batch")
+    {
+        uint32_t threads = argc > 4 && std::string(argv[3]) == "--threads" ? (uint32_t)atoi(argv[4]) : 0;
+        Batch::BatchServer server(std::cout, threads);
+
+        uint32_t invalid;
+        if (std::string(argv[2]) == "-")
+        {
+            invalid = server.Run(std::cin);
+        }
+        else
+        {
+            std::ifstream file(argv[2]);
+            if (!file)
+            {
+                std::cerr << "cannot open " << argv[2] << std::endl;
+                return 1;
+            }
+            invalid = server.Run(file);
+        }
+
+        server.PublishStatistics();
+        Renderer::Profiler::Get().Report(std::cerr);
+        return invalid ? 1 : 0;
+    }
+
+    // Internal resolution at scale 1, the window always presents at twice that
+    const uint32_t maxWidth = 640;
+    const uint32_t maxHeight = 480;
+    const uint32_t windowWidth = 1280;
+    const uint32_t windowHeight = 960;
+    const float targetMs = 16.0f;
+
+    sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight), "Renderer");
+
+    // Targets are allocated for the largest resolution, smaller ones use the first width * height elements
+    Renderer::ThreadPool pool;
+    Renderer::Buffer buffer(16, maxWidth * maxHeight);
+    Renderer::Buffer depth(4, maxWidth * maxHeight);
+    Renderer::OutputStage output(&pool);
+    Renderer::Upscaler upscaler(&pool);
+    Renderer::ResolutionController resolution(maxWidth, maxHeight, targetMs);
+    Renderer::ShadowMap shadowMap(1024);
+
+    Scenes::Scene scene;
+    Scenes::Create("triangles", maxWidth, maxHeight, scene);
+    std::vector<Renderer::Vertex> vertices;
+
+    std::unique_ptr<Renderer::Rasterizer> rasterizer;
+    std::unique_ptr<Renderer::DirtyTiles> dirtyTiles;
+    std::vector<Renderer::Rect> dirtyRects;
+    std::vector<uint32_t> tileOffsets;
+    std::vector<uint32_t> tileTriangles;
+    std::vector<uint8_t> internal(maxWidth * maxHeight * 4);
+    std::vector<uint8_t> presented(windowWidth * windowHeight * 4); // one upscaled region, packed for upload
 
     sf::Texture texture;
-    texture.create(640, 480);
-    texture.update((const sf::Uint8*)buffer.GetData());
+    texture.create(windowWidth, windowHeight);
 
     sf::Sprite sprite;
     sprite.setTexture(texture);
-    sprite.setScale(2.0f, 2.0f);
 
     float fps;
     sf::Clock clock = sf::Clock::Clock();
     sf::Time previousTime = clock.getElapsedTime();
     sf::Time currentTime;
+    bool resized = true;
+    uint64_t shadowKey = 0;
 
     while (window.isOpen())
     {
@@ -31,15 +349,96 @@ int main()
                 window.close();
         }
 
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        uint32_t width = resolution.GetWidth();
+        uint32_t height = resolution.GetHeight();
+
+        // New resolution invalidates everything, scene is scaled from its full resolution layout
+        if (resized)
+        {
+            float scaleX = (float)width / maxWidth;
+            float scaleY = (float)height / maxHeight;
+            vertices = scene.vertices;
+            for (Renderer::Vertex& v : vertices)
+            {
+                v.position.x *= scaleX;
+                v.position.y *= scaleY;
+            }
+
+            rasterizer.reset(new Renderer::Rasterizer(&buffer, &depth, width, height));
+            dirtyTiles.reset(new Renderer::DirtyTiles(width, height));
+
+            // Scene geometry only changes here, dirty tiles then draw just the triangles binned to them
+            BinTriangles(vertices, dirtyTiles->GetGrid(), tileOffsets, tileTriangles);
+
+            // Static scene and light, shadow map only changes with resolution
+            shadowMap.SetLight(0.6f, -0.5f, width, height, 200.0f * scaleX);
+            shadowMap.Render(vertices);
+            resized = false;
+
+            // Shadow map content follows the light and every occluder, so it is part of every shaded draw
+            shadowKey = Renderer::DirtyTiles::Hash(vertices.data(), vertices.size() * sizeof(Renderer::Vertex));
+            for (int r = 0; r < 3; r++)
+            {
+                shadowKey = Renderer::DirtyTiles::Hash(shadowMap.GetMatrixRow(r), 4 * sizeof(float), shadowKey);
+            }
+        }
+
+        // Record this frame's draws, only tiles whose contributing draws changed get cleared and redrawn. Keys hash
+        // the draw's vertices and shader state, a moved or recolored triangle dirties the tiles it touches
+        dirtyTiles->BeginFrame();
+        uint64_t clearKey = Renderer::DirtyTiles::Hash(&scene.clearDepth, sizeof(float), Renderer::DirtyTiles::Hash(&scene.clearColor, sizeof(scene.clearColor)));
+        dirtyTiles->Submit(0, 0, width, height, clearKey);
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        {
+            int x0, y0, x1, y1;
+            TriangleBounds(&vertices[i], x0, y0, x1, y1);
+            dirtyTiles->Submit(x0, y0, x1, y1, Renderer::DirtyTiles::Hash(&vertices[i], 3 * sizeof(Renderer::Vertex), shadowKey));
+        }
+        dirtyTiles->EndFrame();
+
+        Renderer::ShadowShader shadowShader(shadowMap);
+        for (uint32_t tile : dirtyTiles->GetDirtyTiles())
+        {
+            Renderer::Rect r = dirtyTiles->GetGrid().GetTileRect(tile);
+            for (uint32_t y = r.y; y < r.y + r.height; y++)
+            {
+                buffer.Fill(&scene.clearColor, y * width + r.x, r.width);
+                depth.Fill(&scene.clearDepth, y * width + r.x, r.width);
+            }
+
+            // Scissor keeps triangles straddling the tile inside it, only the tile's bin is drawn
+            rasterizer->SetScissor(r);
+            uint32_t begin = tileOffsets[tile];
+            rasterizer->DrawTriangles(vertices.data(), tileTriangles.data() + begin, tileOffsets[tile + 1] - begin, shadowShader);
+        }
+
+        // Tonemap dirty rectangles into the internal resolution image, HDR buffer is read once
+        dirtyTiles->GetDirtyRects(dirtyRects);
+        for (const Renderer::Rect& r : dirtyRects)
+        {
+            output.Process(buffer, width, r, internal.data() + (r.y * width + r.x) * 4, width * 4);
+        }
+
+        // Render time only, presentation and vsync would otherwise drive the resolution down
+        float frameMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+
+        // Only window regions sampling a dirty rectangle are upscaled and uploaded, bilinear taps reach one pixel past it
+        for (const Renderer::Rect& r : dirtyRects)
+        {
+            Renderer::Rect w = Renderer::Upscaler::GetDestinationRect(r, width, height, windowWidth, windowHeight);
+            upscaler.Upscale(internal.data(), width, height, width * 4, presented.data(), windowWidth, windowHeight, w.width * 4, w);
+            texture.update(presented.data(), w.width, w.height, w.x, w.y);
+        }
+        resized = resolution.Update(frameMs);
+
         window.clear();
-        buffer.Clear();
-        texture.update((const sf::Uint8*)buffer.GetData());
         window.draw(sprite);
         window.display();
 
         currentTime = clock.getElapsedTime();
         fps = 1.0f / (currentTime.asSeconds() - previousTime.asSeconds()); // the asSeconds returns a float
-        std::cout << "fps =" << floor(fps) << std::endl; // flooring it will make the frame rate a rounded number
+        std::cout << "fps =" << floor(fps) << " resolution = " << width << "x" << height << " render = " << frameMs << " ms tiles redrawn = " << dirtyTiles->GetRedrawnCount() << " reused = " << dirtyTiles->GetReusedCount() << std::endl; // flooring it will make the frame rate a rounded number
         previousTime = currentTime;
     }
 
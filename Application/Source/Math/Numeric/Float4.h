@@ -40,6 +40,13 @@ namespace Math
 			 */
 			float4(const float4& other) : x(other.x), y(other.y), z(other.z), w(other.w) {}
 
+			/**
+			 * @brief Copy assignment operator.
+			 * @param other The other float4 object to copy from.
+			 * @return Reference to this object.
+			 */
+			float4& operator=(const float4& other) = default;
+
 			/**
 			 * @brief Addition operator.
 			 * @param other The other float4 object to add.
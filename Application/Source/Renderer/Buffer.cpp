@@ -1,25 +1,84 @@
 #include "Buffer.h"
 #include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 namespace Renderer
 {
+	namespace
+	{
+		// Heap may hand out pages another thread already touched, large buffers get fresh ones
+		const uint32_t MappedSize = 64 * 1024;
+	}
+
 	Buffer::Buffer(uint32_t elementSize, uint32_t elementCount)
 		: mElementSize(elementSize), mElementCount(elementCount)
 	{
 		mSize = mElementSize * mElementCount;
+#ifndef _WIN32
+		if (mSize >= MappedSize)
+		{
+			void* data = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (data != MAP_FAILED)
+			{
+				mData = data;
+				mMapped = true;
+				return;
+			}
+		}
+#endif
 		mData = new uint8_t[mSize];
+		mMapped = false;
 	}
 
 	Buffer::~Buffer()
 	{
-		delete[] mData;
+#ifndef _WIN32
+		if (mMapped)
+		{
+			munmap(mData, mSize);
+			return;
+		}
+#endif
+		delete[] (uint8_t*)mData;
 	}
 
 	void Buffer::Clear()
 	{
-		for (uint32_t i = 0; i < mSize; i++)
+		Clear(0, mElementCount);
+	}
+
+	void Buffer::Clear(uint32_t firstElement, uint32_t elementCount)
+	{
+		uint32_t begin = firstElement * mElementSize;
+		uint32_t end = begin + elementCount * mElementSize;
+		for (uint32_t i = begin; i < end; i++)
 		{
 			((uint8_t*)mData)[i] = rand() % 255;
 		}
 	}
+
+	void Buffer::Fill(const void* element)
+	{
+		Fill(element, 0, mElementCount);
+	}
+
+	void Buffer::Fill(const void* element, uint32_t firstElement, uint32_t elementCount)
+	{
+		if (elementCount == 0)
+		{
+			return;
+		}
+
+		// Replicate first element by doubling copied range
+		uint8_t* data = (uint8_t*)mData + firstElement * mElementSize;
+		uint32_t size = elementCount * mElementSize;
+		memcpy(data, element, mElementSize);
+		for (uint32_t filled = mElementSize; filled < size; filled *= 2)
+		{
+			memcpy(data + filled, data, filled < size - filled ? filled : size - filled);
+		}
+	}
 }
\ No newline at end of file
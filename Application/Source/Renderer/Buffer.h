@@ -4,6 +4,13 @@
 
 namespace Renderer
 {
+	/**
+	 * @class Buffer
+	 * @brief Uninitialized array of fixed size elements.
+	 *
+	 * Large buffers are mapped straight from the OS (except on Windows), so none of their pages is touched before
+	 * the first write and Linux places each page on the NUMA node of the thread writing it first.
+	 */
 	class Buffer
 	{
 	protected:
@@ -12,12 +19,16 @@ namespace Renderer
 		uint32_t mSize;
 		uint32_t mElementSize;
 		uint32_t mElementCount;
+		bool mMapped;
 
 	public:
 		Buffer(uint32_t elementSize, uint32_t elementCount);
 		virtual ~Buffer();
 
 		void Clear();
+		void Clear(uint32_t firstElement, uint32_t elementCount);
+		void Fill(const void* element);
+		void Fill(const void* element, uint32_t firstElement, uint32_t elementCount);
 
 		void* GetData() const { return mData; }
 		uint32_t GetSize() const { return mSize; }
@@ -0,0 +1,64 @@
+#include "BufferPool.h"
+#include <chrono>
+
+namespace Renderer
+{
+	BufferPool::BufferPool(uint32_t elementSize, uint32_t elementCount, uint32_t count)
+		: mWaitMs(0.0)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			mBuffers.push_back(std::unique_ptr<Buffer>(new Buffer(elementSize, elementCount)));
+			mFree.push_back(mBuffers.back().get());
+		}
+	}
+
+	Buffer* BufferPool::Acquire()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mFree.empty())
+		{
+			auto start = std::chrono::steady_clock::now();
+			mReleased.wait(lock, [&]() { return !mFree.empty(); });
+			mWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		Buffer* buffer = mFree.back();
+		mFree.pop_back();
+		return buffer;
+	}
+
+	Buffer* BufferPool::TryAcquire()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mFree.empty())
+		{
+			return nullptr;
+		}
+
+		Buffer* buffer = mFree.back();
+		mFree.pop_back();
+		return buffer;
+	}
+
+	void BufferPool::Release(Buffer* buffer)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFree.push_back(buffer);
+		}
+		mReleased.notify_one();
+	}
+
+	uint32_t BufferPool::GetFreeCount() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return (uint32_t)mFree.size();
+	}
+
+	double BufferPool::GetWaitMs() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mWaitMs;
+	}
+}
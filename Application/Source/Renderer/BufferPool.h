@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Buffer.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class BufferPool
+	 * @brief Fixed set of equally sized Buffers handed out and returned across threads.
+	 *
+	 * All buffers are allocated up front, so the pool bounds memory and Acquire is where backpressure happens:
+	 * it blocks until a consumer releases a buffer. Time spent blocked is accumulated for profiling.
+	 */
+	class BufferPool
+	{
+	protected:
+		std::vector<std::unique_ptr<Buffer>> mBuffers;
+		std::vector<Buffer*> mFree;
+		mutable std::mutex mMutex;
+		std::condition_variable mReleased;
+		double mWaitMs;
+
+	public:
+		BufferPool(uint32_t elementSize, uint32_t elementCount, uint32_t count);
+
+		/**
+		 * @brief Returns free buffer, waits until one is released if none is free.
+		 */
+		Buffer* Acquire();
+
+		/**
+		 * @brief Returns free buffer or null if all are in use.
+		 */
+		Buffer* TryAcquire();
+
+		void Release(Buffer* buffer);
+
+		uint32_t GetCount() const { return (uint32_t)mBuffers.size(); }
+		uint32_t GetFreeCount() const;
+		/** @brief Total time Acquire spent waiting for a buffer. */
+		double GetWaitMs() const;
+	};
+}
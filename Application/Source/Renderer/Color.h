@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../Math/Numeric/Float4.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace Renderer
+{
+	/**
+	 * @brief Packs color in [0, 1] to RGBA8 (red in lowest byte, as uploaded to texture).
+	 */
+	inline uint32_t PackColor(const Math::Numeric::float4& c)
+	{
+		uint32_t r = (uint32_t)(std::min(std::max(c.x, 0.0f), 1.0f) * 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(std::min(std::max(c.y, 0.0f), 1.0f) * 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(std::min(std::max(c.z, 0.0f), 1.0f) * 255.0f + 0.5f);
+		uint32_t a = (uint32_t)(std::min(std::max(c.w, 0.0f), 1.0f) * 255.0f + 0.5f);
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	/**
+	 * @brief Unpacks RGBA8 color to [0, 1].
+	 */
+	inline Math::Numeric::float4 UnpackColor(uint32_t c)
+	{
+		return Math::Numeric::float4((float)(c & 0xFF), (float)((c >> 8) & 0xFF), (float)((c >> 16) & 0xFF), (float)(c >> 24)) * (1.0f / 255.0f);
+	}
+}
@@ -0,0 +1,222 @@
+#include "CpuTopology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <thread>
+
+namespace Renderer
+{
+	namespace
+	{
+		const std::string CpuRoot = "/sys/devices/system/cpu/";
+		const std::string NodeRoot = "/sys/devices/system/node/";
+
+		bool ReadLine(const std::string& path, std::string& line)
+		{
+			std::ifstream file(path);
+			return file && std::getline(file, line) && !line.empty();
+		}
+
+		bool ReadNumber(const std::string& path, uint32_t& value)
+		{
+			std::string line;
+			if (!ReadLine(path, line))
+			{
+				return false;
+			}
+			value = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+			return true;
+		}
+
+		/**
+		 * @brief Cache size like "48K" or "32M".
+		 */
+		uint32_t ParseSize(const std::string& text)
+		{
+			uint32_t value = (uint32_t)strtoul(text.c_str(), nullptr, 10);
+			char unit = text.empty() ? 0 : text.back();
+			return unit == 'K' ? value * 1024 : (unit == 'M' ? value * 1024 * 1024 : value);
+		}
+	}
+
+	bool CpuTopology::ParseList(const std::string& text, std::vector<uint32_t>& values)
+	{
+		values.clear();
+		size_t position = 0;
+		while (position < text.size())
+		{
+			size_t end = text.find(',', position);
+			std::string range = text.substr(position, end == std::string::npos ? std::string::npos : end - position);
+			position = end == std::string::npos ? text.size() : end + 1;
+			if (range.empty() || range[0] < '0' || range[0] > '9')
+			{
+				return false;
+			}
+
+			size_t dash = range.find('-');
+			uint32_t first = (uint32_t)strtoul(range.c_str(), nullptr, 10);
+			uint32_t last = dash == std::string::npos ? first : (uint32_t)strtoul(range.c_str() + dash + 1, nullptr, 10);
+			for (uint32_t value = first; value <= last; value++)
+			{
+				values.push_back(value);
+			}
+		}
+		return !values.empty();
+	}
+
+	CpuTopology CpuTopology::Detect()
+	{
+		CpuTopology topology;
+		topology.nodeCount = 1;
+		topology.l2Bytes = 0;
+		topology.lastLevelBytes = 0;
+		topology.detected = false;
+
+		std::string line;
+		std::vector<uint32_t> online;
+		if (!ReadLine(CpuRoot + "online", line) || !ParseList(line, online))
+		{
+			uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				Cpu cpu = { i, i, 0, 0, 0 };
+				topology.cpus.push_back(cpu);
+			}
+			return topology;
+		}
+
+		for (uint32_t id : online)
+		{
+			std::string root = CpuRoot + "cpu" + std::to_string(id) + "/";
+			Cpu cpu = { id, id, 0, 0, 0 };
+			ReadNumber(root + "topology/core_id", cpu.core);
+			ReadNumber(root + "topology/physical_package_id", cpu.package);
+
+			// Highest cache level wins, its shared CPU list defines the cache domain
+			uint32_t lastLevel = 0;
+			for (uint32_t index = 0; ; index++)
+			{
+				std::string cache = root + "cache/index" + std::to_string(index) + "/";
+				uint32_t level;
+				if (!ReadNumber(cache + "level", level))
+				{
+					break;
+				}
+
+				std::string type;
+				ReadLine(cache + "type", type);
+				if (type == "Instruction")
+				{
+					continue;
+				}
+
+				std::string size;
+				ReadLine(cache + "size", size);
+				if (level == 2)
+				{
+					topology.l2Bytes = ParseSize(size);
+				}
+
+				std::vector<uint32_t> shared;
+				if (level >= lastLevel && ReadLine(cache + "shared_cpu_list", line) && ParseList(line, shared))
+				{
+					lastLevel = level;
+					cpu.cacheDomain = shared[0];
+					topology.lastLevelBytes = ParseSize(size);
+				}
+			}
+			topology.cpus.push_back(cpu);
+		}
+
+		// Node ids may be sparse, they are renumbered densely
+		std::vector<uint32_t> nodes;
+		if (ReadLine(NodeRoot + "online", line) && ParseList(line, nodes))
+		{
+			topology.nodeCount = (uint32_t)nodes.size();
+			for (uint32_t n = 0; n < nodes.size(); n++)
+			{
+				std::vector<uint32_t> members;
+				if (ReadLine(NodeRoot + "node" + std::to_string(nodes[n]) + "/cpulist", line) && ParseList(line, members))
+				{
+					for (Cpu& cpu : topology.cpus)
+					{
+						if (std::find(members.begin(), members.end(), cpu.id) != members.end())
+						{
+							cpu.node = n;
+						}
+					}
+				}
+			}
+		}
+
+		topology.detected = true;
+		return topology;
+	}
+
+	std::vector<uint32_t> CpuTopology::GetPinningOrder() const
+	{
+		// Rank of every CPU among the SMT siblings of its core, rank 0 CPUs are placed first
+		std::map<uint64_t, uint32_t> siblings;
+		std::vector<uint32_t> rank(cpus.size());
+		uint32_t maxRank = 0;
+		for (size_t i = 0; i < cpus.size(); i++)
+		{
+			rank[i] = siblings[((uint64_t)cpus[i].package << 32) | cpus[i].core]++;
+			maxRank = std::max(maxRank, rank[i]);
+		}
+
+		std::vector<std::vector<uint32_t>> perNode(nodeCount);
+		for (uint32_t r = 0; r <= maxRank; r++)
+		{
+			for (size_t i = 0; i < cpus.size(); i++)
+			{
+				if (rank[i] == r)
+				{
+					perNode[cpus[i].node].push_back((uint32_t)i);
+				}
+			}
+		}
+
+		// Round robin across nodes keeps per-node thread counts balanced for any pool size
+		std::vector<uint32_t> order;
+		for (size_t k = 0; order.size() < cpus.size(); k++)
+		{
+			for (uint32_t n = 0; n < nodeCount; n++)
+			{
+				if (k < perNode[n].size())
+				{
+					order.push_back(perNode[n][k]);
+				}
+			}
+		}
+		return order;
+	}
+
+	void CpuTopology::Report(std::ostream& stream) const
+	{
+		std::map<uint64_t, int> cores;
+		std::map<uint32_t, int> domains;
+		for (const Cpu& cpu : cpus)
+		{
+			cores[((uint64_t)cpu.package << 32) | cpu.core]++;
+			domains[cpu.cacheDomain]++;
+		}
+
+		stream << "topology = " << (detected ? "sysfs" : "fallback") << ", cpus = " << cpus.size() << ", cores = " << cores.size()
+			<< ", nodes = " << nodeCount << ", last level caches = " << domains.size() << " x " << lastLevelBytes / 1024
+			<< " kB, l2 = " << l2Bytes / 1024 << " kB" << std::endl;
+		for (uint32_t n = 0; n < nodeCount; n++)
+		{
+			stream << "node " << n << ":";
+			for (const Cpu& cpu : cpus)
+			{
+				if (cpu.node == n)
+				{
+					stream << " " << cpu.id;
+				}
+			}
+			stream << std::endl;
+		}
+	}
+}
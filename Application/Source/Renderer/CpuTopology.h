@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @struct CpuTopology
+	 * @brief Logical CPUs with their core, package, NUMA node and last level cache, read from Linux sysfs.
+	 *
+	 * Elsewhere (or without sysfs) every one of hardware_concurrency CPUs is its own core on node 0 and nothing
+	 * can be pinned.
+	 */
+	struct CpuTopology
+	{
+		struct Cpu
+		{
+			uint32_t id;
+			uint32_t core;
+			uint32_t package;
+			uint32_t node;
+			/** @brief Lowest CPU id sharing the last level cache, CPUs with equal value share it. */
+			uint32_t cacheDomain;
+		};
+
+		std::vector<Cpu> cpus;
+		uint32_t nodeCount;
+		uint32_t l2Bytes;
+		uint32_t lastLevelBytes;
+		/** @brief True when read from sysfs, pinning is possible. */
+		bool detected;
+
+		static CpuTopology Detect();
+
+		/**
+		 * @brief Indices into cpus to place threads in: one per physical core round robin across nodes, then SMT
+		 * siblings.
+		 */
+		std::vector<uint32_t> GetPinningOrder() const;
+
+		/**
+		 * @brief Prints nodes, cores, caches and CPU lists.
+		 */
+		void Report(std::ostream& stream) const;
+
+		/**
+		 * @brief Parses sysfs CPU list like "0-3,8,10-11".
+		 */
+		static bool ParseList(const std::string& text, std::vector<uint32_t>& values);
+	};
+}
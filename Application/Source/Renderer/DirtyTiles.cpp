@@ -0,0 +1,130 @@
+#include "DirtyTiles.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace Renderer
+{
+	namespace
+	{
+		const uint64_t SignatureSeed = 14695981039346656037ull;
+		const uint64_t SignaturePrime = 1099511628211ull;
+	}
+
+	DirtyTiles::DirtyTiles(uint32_t width, uint32_t height, uint32_t tileSize)
+		: mGrid(width, height, tileSize), mReused(0), mRedrawn(0), mInvalidated(true)
+	{
+		mCurrent.resize(mGrid.GetTileCount(), SignatureSeed);
+		mPrevious.resize(mGrid.GetTileCount(), SignatureSeed);
+		mDirty.resize(mGrid.GetTileCount(), 1);
+		mDirtyList.reserve(mGrid.GetTileCount());
+	}
+
+	void DirtyTiles::BeginFrame()
+	{
+		mPrevious.swap(mCurrent);
+		std::fill(mCurrent.begin(), mCurrent.end(), SignatureSeed);
+	}
+
+	void DirtyTiles::Submit(int x0, int y0, int x1, int y1, uint64_t drawKey)
+	{
+		x0 = std::max(x0, 0);
+		y0 = std::max(y0, 0);
+		x1 = std::min(x1, (int)mGrid.GetWidth());
+		y1 = std::min(y1, (int)mGrid.GetHeight());
+		if (x0 >= x1 || y0 >= y1)
+		{
+			return;
+		}
+
+		uint32_t tileSize = mGrid.GetTileSize();
+		uint32_t tx0 = x0 / tileSize;
+		uint32_t ty0 = y0 / tileSize;
+		uint32_t tx1 = (x1 - 1) / tileSize;
+		uint32_t ty1 = (y1 - 1) / tileSize;
+
+		for (uint32_t ty = ty0; ty <= ty1; ty++)
+		{
+			for (uint32_t tx = tx0; tx <= tx1; tx++)
+			{
+				// Order dependent on purpose, reordering blended draws changes the tile
+				uint64_t& signature = mCurrent[ty * mGrid.GetTilesX() + tx];
+				signature = (signature ^ drawKey) * SignaturePrime;
+			}
+		}
+	}
+
+	uint64_t DirtyTiles::Hash(const void* data, size_t size, uint64_t hash)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * SignaturePrime;
+		}
+		return hash;
+	}
+
+	void DirtyTiles::Invalidate()
+	{
+		mInvalidated = true;
+	}
+
+	void DirtyTiles::EndFrame()
+	{
+		mDirtyList.clear();
+		for (uint32_t i = 0; i < mGrid.GetTileCount(); i++)
+		{
+			mDirty[i] = (mInvalidated || mCurrent[i] != mPrevious[i]) ? 1 : 0;
+			if (mDirty[i])
+			{
+				mDirtyList.push_back(i);
+			}
+		}
+		mInvalidated = false;
+
+		mRedrawn = (uint32_t)mDirtyList.size();
+		mReused = mGrid.GetTileCount() - mRedrawn;
+
+		Profiler::Get().Set("tiles.redrawn", mRedrawn);
+		Profiler::Get().Set("tiles.reused", mReused);
+	}
+
+	void DirtyTiles::ClearDirty(Buffer& buffer) const
+	{
+		for (uint32_t tile : mDirtyList)
+		{
+			Rect r = mGrid.GetTileRect(tile);
+			for (uint32_t y = r.y; y < r.y + r.height; y++)
+			{
+				buffer.Clear(y * mGrid.GetWidth() + r.x, r.width);
+			}
+		}
+	}
+
+	void DirtyTiles::GetDirtyRects(std::vector<Rect>& rects) const
+	{
+		rects.clear();
+		for (uint32_t ty = 0; ty < mGrid.GetTilesY(); ty++)
+		{
+			uint32_t tx = 0;
+			while (tx < mGrid.GetTilesX())
+			{
+				if (!mDirty[ty * mGrid.GetTilesX() + tx])
+				{
+					tx++;
+					continue;
+				}
+
+				uint32_t first = tx;
+				while (tx < mGrid.GetTilesX() && mDirty[ty * mGrid.GetTilesX() + tx])
+				{
+					tx++;
+				}
+
+				Rect begin = mGrid.GetTileRect(ty * mGrid.GetTilesX() + first);
+				Rect end = mGrid.GetTileRect(ty * mGrid.GetTilesX() + tx - 1);
+				begin.width = end.x + end.width - begin.x;
+				rects.push_back(begin);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Buffer.h"
+#include "TileGrid.h"
+#include <cstddef>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class DirtyTiles
+	 * @brief Tracks which tiles need to be re-rasterized between frames.
+	 *
+	 * Every draw submitted during a frame is folded (in submission order) into a signature of each tile it
+	 * overlaps. A tile whose signature matches the previous frame has exactly the same contributing geometry
+	 * and can be reused - it is neither cleared, re-rasterized nor uploaded again.
+	 */
+	class DirtyTiles
+	{
+	protected:
+		TileGrid mGrid;
+
+		std::vector<uint64_t> mCurrent;
+		std::vector<uint64_t> mPrevious;
+		std::vector<uint8_t> mDirty;
+		std::vector<uint32_t> mDirtyList;
+
+		uint32_t mReused;
+		uint32_t mRedrawn;
+		bool mInvalidated;
+
+	public:
+		DirtyTiles(uint32_t width, uint32_t height, uint32_t tileSize = 64);
+
+		/**
+		 * @brief Starts recording draws for a new frame.
+		 */
+		void BeginFrame();
+
+		/**
+		 * @brief Records a draw touching pixel rectangle [x0, x1) x [y0, y1).
+		 * @param drawKey Hash of everything that affects the draw output (geometry, state, ...).
+		 */
+		void Submit(int x0, int y0, int x1, int y1, uint64_t drawKey);
+
+		/**
+		 * @brief Marks all tiles dirty for the next EndFrame (first frame, resize, lost contents).
+		 */
+		void Invalidate();
+
+		/**
+		 * @brief Compares recorded signatures against previous frame and builds the dirty tile list.
+		 */
+		void EndFrame();
+
+		/**
+		 * @brief Clears only dirty tiles of a width x height buffer.
+		 */
+		void ClearDirty(Buffer& buffer) const;
+
+		/**
+		 * @brief Gets dirty tiles merged into horizontal runs, suitable for partial texture uploads.
+		 */
+		void GetDirtyRects(std::vector<Rect>& rects) const;
+
+		/**
+		 * @brief FNV-1a of size bytes continuing hash, draw keys are built by chaining it over draw inputs.
+		 */
+		static uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+		bool IsDirty(uint32_t tile) const { return mDirty[tile] != 0; }
+		const std::vector<uint32_t>& GetDirtyTiles() const { return mDirtyList; }
+		const TileGrid& GetGrid() const { return mGrid; }
+		uint32_t GetReusedCount() const { return mReused; }
+		uint32_t GetRedrawnCount() const { return mRedrawn; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "FragmentBuffer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace Renderer
+{
+	namespace
+	{
+		inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		/**
+		 * @brief Premultiplied over, composites back behind front in place.
+		 */
+		inline void CompositeOver(float* front, const float* back)
+		{
+			__m128 f = _mm_loadu_ps(front);
+			__m128 transmittance = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 3, 3, 3)));
+			_mm_storeu_ps(front, _mm_add_ps(f, _mm_mul_ps(_mm_loadu_ps(back), transmittance)));
+		}
+
+		/**
+		 * @brief Compare-exchange of lanes (0, 1) and (2, 3).
+		 */
+		inline __m128 SortPairs(__m128 v)
+		{
+			__m128 t = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+			return Select(_mm_castsi128_ps(_mm_set_epi32(0, -1, 0, -1)), _mm_min_ps(v, t), _mm_max_ps(v, t));
+		}
+
+		/**
+		 * @brief Sorting network for 4 lanes: pairs, reversed halves, pairs.
+		 */
+		inline __m128 Sort4(__m128 v)
+		{
+			v = SortPairs(v);
+			__m128 t = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+			v = Select(_mm_castsi128_ps(_mm_set_epi32(0, 0, -1, -1)), _mm_min_ps(v, t), _mm_max_ps(v, t));
+			return SortPairs(v);
+		}
+
+		/**
+		 * @brief Sorts bitonic 4 lanes: halves, then pairs.
+		 */
+		inline __m128 BitonicMerge4(__m128 v)
+		{
+			__m128 t = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2));
+			v = Select(_mm_castsi128_ps(_mm_set_epi32(0, 0, -1, -1)), _mm_min_ps(v, t), _mm_max_ps(v, t));
+			return SortPairs(v);
+		}
+
+		/**
+		 * @brief Sorts 8 lanes, a gets the 4 smallest.
+		 */
+		inline void Sort8(__m128& a, __m128& b)
+		{
+			a = Sort4(a);
+			b = Sort4(b);
+			__m128 reversed = _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3));
+			__m128 low = _mm_min_ps(a, reversed);
+			__m128 high = _mm_max_ps(a, reversed);
+			a = BitonicMerge4(low);
+			b = BitonicMerge4(high);
+		}
+
+		/**
+		 * @brief Sort keys: non-negative depth bits order like floats, lowest 3 mantissa bits replaced by slot.
+		 */
+		inline __m128 MakeKeys(__m128 depth, __m128i slots)
+		{
+			__m128i bits = _mm_castps_si128(_mm_max_ps(depth, _mm_setzero_ps()));
+			bits = _mm_or_si128(_mm_andnot_si128(_mm_set1_epi32(7), bits), slots);
+			return _mm_castsi128_ps(bits);
+		}
+	}
+
+	FragmentBuffer::FragmentBuffer(uint32_t width, uint32_t height, uint32_t capacity)
+		: mWidth(width), mHeight(height), mCapacity(capacity), mPool(width * height + capacity), mHeads(width * height, Empty),
+		mCounts(width * height, 0), mUsed(0)
+	{
+		ResetStatistics();
+	}
+
+	void FragmentBuffer::Clear()
+	{
+		// Heads of pixels with zero count are never read, only counts need clearing
+		memset(mCounts.data(), 0, mCounts.size());
+		mUsed = 0;
+	}
+
+	void FragmentBuffer::ResetStatistics()
+	{
+		memset(&mStatistics, 0, sizeof(mStatistics));
+	}
+
+	void FragmentBuffer::Merge(uint32_t pixel, const Fragment& fragment)
+	{
+		uint32_t farthest = mHeads[pixel];
+		uint32_t second = Empty;
+		for (uint32_t i = mPool[farthest].next; i != Empty; i = mPool[i].next)
+		{
+			if (mPool[i].depth > mPool[farthest].depth)
+			{
+				second = farthest;
+				farthest = i;
+			}
+			else if (second == Empty || mPool[i].depth > mPool[second].depth)
+			{
+				second = i;
+			}
+		}
+
+		// Always the two farthest of stored and incoming fragments are merged, so layers in front stay exact. A
+		// nearer incoming fragment takes the farthest slot and the evicted one is merged into the second farthest.
+		Fragment evicted = mPool[farthest];
+		if (second != Empty && fragment.depth < mPool[second].depth)
+		{
+			mPool[farthest].depth = fragment.depth;
+			memcpy(mPool[farthest].color, fragment.color, sizeof(fragment.color));
+			CompositeOver(mPool[second].color, evicted.color);
+			return;
+		}
+
+		Fragment& stored = mPool[farthest];
+		const Fragment& nearer = fragment.depth < evicted.depth ? fragment : evicted;
+		const Fragment& farther = fragment.depth < evicted.depth ? evicted : fragment;
+		stored.depth = nearer.depth;
+		memcpy(stored.color, nearer.color, sizeof(nearer.color));
+		CompositeOver(stored.color, farther.color);
+	}
+
+	void FragmentBuffer::Insert(uint32_t index, int mask, const PacketFloat4& color, __m128 depth)
+	{
+		// Premultiply, then transpose to one RGBA register per lane
+		__m128 r = _mm_mul_ps(color.x, color.w);
+		__m128 g = _mm_mul_ps(color.y, color.w);
+		__m128 b = _mm_mul_ps(color.z, color.w);
+		__m128 a = color.w;
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+		__m128 lanes[4] = { r, g, b, a };
+
+		float depths[4];
+		_mm_storeu_ps(depths, depth);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (!(mask & (1 << lane)))
+			{
+				continue;
+			}
+
+			uint32_t pixel = index + lane;
+			Fragment fragment;
+			_mm_storeu_ps(fragment.color, lanes[lane]);
+			fragment.depth = depths[lane];
+			mStatistics.fragments++;
+
+			uint8_t& count = mCounts[pixel];
+			if (!count)
+			{
+				fragment.next = Empty;
+				mPool[pixel] = fragment;
+				mHeads[pixel] = pixel;
+				count++;
+			}
+			else if (count < MaxLayers && mUsed < mCapacity)
+			{
+				uint32_t slot = mWidth * mHeight + mUsed++;
+				fragment.next = mHeads[pixel];
+				mPool[slot] = fragment;
+				mHeads[pixel] = slot;
+				count++;
+				mStatistics.peak = std::max(mStatistics.peak, mUsed);
+			}
+			else
+			{
+				Merge(pixel, fragment);
+				mStatistics.merged++;
+			}
+		}
+	}
+
+	void FragmentBuffer::Resolve(Buffer& color) const
+	{
+		bool hdr = color.GetElementSize() == 16;
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128i slotsLow = _mm_set_epi32(3, 2, 1, 0);
+		__m128i slotsHigh = _mm_set_epi32(7, 6, 5, 4);
+
+		for (uint32_t pixel = 0; pixel < mWidth * mHeight; pixel++)
+		{
+			uint32_t count = mCounts[pixel];
+			if (!count)
+			{
+				continue;
+			}
+
+			// Gather list, unused lanes sort last
+			const Fragment* fragments[MaxLayers];
+			float depths[MaxLayers];
+			uint32_t n = 0;
+			for (uint32_t i = mHeads[pixel]; n < count; i = mPool[i].next)
+			{
+				fragments[n] = &mPool[i];
+				depths[n++] = mPool[i].depth;
+			}
+			for (; n < MaxLayers; n++)
+			{
+				depths[n] = FLT_MAX;
+			}
+
+			__m128 low = MakeKeys(_mm_loadu_ps(depths), slotsLow);
+			__m128 high = MakeKeys(_mm_loadu_ps(depths + 4), slotsHigh);
+			if (count <= 4)
+			{
+				low = Sort4(low);
+			}
+			else
+			{
+				Sort8(low, high);
+			}
+
+			uint32_t keys[MaxLayers];
+			_mm_storeu_si128((__m128i*)keys, _mm_castps_si128(low));
+			_mm_storeu_si128((__m128i*)(keys + 4), _mm_castps_si128(high));
+
+			// Front to back, accumulated premultiplied color and remaining transmittance
+			__m128 accumulated = _mm_setzero_ps();
+			__m128 transmittance = one;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				__m128 fragment = _mm_loadu_ps(fragments[keys[i] & 7]->color);
+				accumulated = _mm_add_ps(accumulated, _mm_mul_ps(fragment, transmittance));
+				transmittance = _mm_mul_ps(transmittance, _mm_sub_ps(one, _mm_shuffle_ps(fragment, fragment, _MM_SHUFFLE(3, 3, 3, 3))));
+			}
+
+			if (hdr)
+			{
+				float* target = (float*)color.GetData() + (size_t)pixel * 4;
+				_mm_storeu_ps(target, _mm_add_ps(accumulated, _mm_mul_ps(_mm_loadu_ps(target), transmittance)));
+			}
+			else
+			{
+				uint32_t* target = (uint32_t*)color.GetData() + pixel;
+				__m128i unpacked = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)*target), _mm_setzero_si128()), _mm_setzero_si128());
+				__m128 background = _mm_mul_ps(_mm_cvtepi32_ps(unpacked), _mm_set1_ps(1.0f / 255.0f));
+				__m128 result = _mm_add_ps(accumulated, _mm_mul_ps(background, transmittance));
+				result = _mm_min_ps(_mm_max_ps(result, _mm_setzero_ps()), one);
+				__m128i packed = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(result, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+				packed = _mm_packs_epi32(packed, packed);
+				*target = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Shader.h"
+#include <cstdint>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class FragmentBuffer
+	 * @brief Bounded k-buffer of transparent fragments for order-independent transparency.
+	 *
+	 * Every pixel owns one fragment slot and links up to MaxLayers - 1 more from a fixed pool shared by all pixels,
+	 * so memory is known up front and never grows with scene depth complexity. When a fragment arrives at a full pixel
+	 * (or the pool is exhausted) the two farthest of the stored fragments and the incoming one are composited into
+	 * one, so total opacity stays exact, the front layers resolve the same whatever the arrival order and only
+	 * order among the merged back layers is approximated. No fragment is ever dropped.
+	 *
+	 * Resolve sorts every pixel list with an SSE sorting network and composites front to back over the opaque
+	 * color already in the target.
+	 */
+	class FragmentBuffer
+	{
+	public:
+		static const int MaxLayers = 8;
+
+		struct Statistics
+		{
+			uint64_t fragments;
+			uint64_t merged;
+			/** @brief Most shared pool entries used between two Clear calls. */
+			uint32_t peak;
+		};
+
+	protected:
+		/**
+		 * @brief Premultiplied RGBA and depth, next links the pixel list (Empty ends it).
+		 */
+		struct Fragment
+		{
+			float color[4];
+			float depth;
+			uint32_t next;
+		};
+
+		static const uint32_t Empty = 0xffffffff;
+
+		uint32_t mWidth;
+		uint32_t mHeight;
+		uint32_t mCapacity;
+		/** @brief Pixel slots (one per pixel) followed by capacity shared entries. */
+		std::vector<Fragment> mPool;
+		std::vector<uint32_t> mHeads;
+		std::vector<uint8_t> mCounts;
+		uint32_t mUsed;
+
+		Statistics mStatistics;
+
+		void Merge(uint32_t pixel, const Fragment& fragment);
+
+	public:
+		/**
+		 * @param capacity Fragments shared by all pixels on top of the one every pixel owns.
+		 */
+		FragmentBuffer(uint32_t width, uint32_t height, uint32_t capacity);
+
+		/**
+		 * @brief Empties all pixel lists, statistics are kept.
+		 */
+		void Clear();
+
+		/**
+		 * @brief Stores shaded packet (straight alpha) for lanes in mask, pixel index is y * width + x of lane 0.
+		 */
+		void Insert(uint32_t index, int mask, const PacketFloat4& color, __m128 depth);
+
+		/**
+		 * @brief Composites sorted fragments over RGBA8 or float4 color target of width * height elements.
+		 */
+		void Resolve(Buffer& color) const;
+
+		uint32_t GetCapacity() const { return mCapacity; }
+
+		/** @brief Pixel slots, shared pool, list heads and counts. */
+		size_t GetBytes() const { return mPool.size() * sizeof(Fragment) + mHeads.size() * sizeof(uint32_t) + mCounts.size(); }
+
+		const Statistics& GetStatistics() const { return mStatistics; }
+		void ResetStatistics();
+	};
+}
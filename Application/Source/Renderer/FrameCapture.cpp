@@ -0,0 +1,252 @@
+#include "FrameCapture.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Renderer
+{
+	namespace
+	{
+		const char Magic[8] = { 'R', 'C', 'A', 'P', 'T', 'U', 'R', 'E' };
+		const uint32_t Version = 1;
+		const uint64_t Alignment = 64;
+
+		enum SectionType : uint32_t
+		{
+			State = 1,
+			OpaqueVertices = 2,
+			TransparentVertices = 3
+		};
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t sectionCount;
+			uint64_t fileSize;
+			uint32_t vertexSize;
+			uint32_t reserved[9];
+		};
+
+		struct Section
+		{
+			uint32_t type;
+			uint32_t count;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		static_assert(sizeof(Header) == 64, "capture header layout");
+		static_assert(sizeof(CaptureState) == 64, "capture state layout");
+		static_assert(sizeof(Vertex) == 48, "capture vertex layout");
+
+		uint64_t Align(uint64_t offset)
+		{
+			return (offset + Alignment - 1) & ~(Alignment - 1);
+		}
+
+		/**
+		 * @brief Section table of a capture, offsets computed from content sizes.
+		 */
+		void Layout(const FrameCapture& capture, Section sections[3], uint64_t& fileSize)
+		{
+			sections[0] = { State, 1, 0, sizeof(CaptureState) };
+			sections[1] = { OpaqueVertices, (uint32_t)capture.opaque.size(), 0, capture.opaque.size() * sizeof(Vertex) };
+			sections[2] = { TransparentVertices, (uint32_t)capture.transparent.size(), 0, capture.transparent.size() * sizeof(Vertex) };
+
+			uint64_t offset = Align(sizeof(Header) + 3 * sizeof(Section));
+			for (int i = 0; i < 3; i++)
+			{
+				sections[i].offset = offset;
+				offset = Align(offset + sections[i].size);
+			}
+			fileSize = offset;
+		}
+
+		/**
+		 * @brief Checks state and vertex counts before anything is sized or divided by them.
+		 *
+		 * Targets are Buffers with 32 bit byte sizes, so a float4 color target of the frame must fit, tiles too.
+		 */
+		bool IsValid(const CaptureState& state, const std::vector<Vertex>& opaque, const std::vector<Vertex>& transparent)
+		{
+			const uint32_t strides[] = { 3, 2, 1 };
+			const uint64_t maxBytes = 0xffffffffull;
+			if (state.width == 0 || state.height == 0 || (uint64_t)state.width * state.height * 16 > maxBytes ||
+				state.tileSize == 0 || (uint64_t)state.tileSize * state.tileSize * 16 > maxBytes)
+			{
+				return false;
+			}
+
+			if ((state.colorElementSize != 4 && state.colorElementSize != 16) || state.topology > 2 || !std::isfinite(state.pointSize) ||
+				state.pointSize <= 0.0f)
+			{
+				return false;
+			}
+
+			// Transparent lists are always triangles, and only drawn over opaque triangles
+			return opaque.size() % strides[state.topology] == 0 && transparent.size() % 3 == 0 && (transparent.empty() || state.topology == 0);
+		}
+
+		/**
+		 * @brief Read-only view of a whole file, memory mapped where available.
+		 */
+		class MappedFile
+		{
+		protected:
+			const uint8_t* mData;
+			uint64_t mSize;
+#ifdef _WIN32
+			std::vector<uint8_t> mContents;
+#endif
+
+		public:
+			MappedFile(const std::string& path) : mData(nullptr), mSize(0)
+			{
+#ifdef _WIN32
+				std::ifstream file(path, std::ios::binary);
+				if (file)
+				{
+					mContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+					mData = mContents.data();
+					mSize = mContents.size();
+				}
+#else
+				int descriptor = open(path.c_str(), O_RDONLY);
+				struct stat status;
+				if (descriptor >= 0 && fstat(descriptor, &status) == 0 && status.st_size > 0)
+				{
+					void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+					if (data != MAP_FAILED)
+					{
+						mData = (const uint8_t*)data;
+						mSize = (uint64_t)status.st_size;
+					}
+				}
+				if (descriptor >= 0)
+				{
+					close(descriptor);
+				}
+#endif
+			}
+
+			~MappedFile()
+			{
+#ifndef _WIN32
+				if (mData)
+				{
+					munmap((void*)mData, (size_t)mSize);
+				}
+#endif
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const uint8_t* GetData() const { return mData; }
+			uint64_t GetSize() const { return mSize; }
+		};
+	}
+
+	uint64_t FrameCapture::GetFileSize() const
+	{
+		Section sections[3];
+		uint64_t fileSize;
+		Layout(*this, sections, fileSize);
+		return fileSize;
+	}
+
+	bool FrameCapture::Save(const std::string& path) const
+	{
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = Version;
+		header.sectionCount = 3;
+		header.vertexSize = sizeof(Vertex);
+
+		Section sections[3];
+		Layout(*this, sections, header.fileSize);
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+
+		// Padding between sections is written as zeros so captures of equal frames are byte identical
+		std::vector<uint8_t> image(sections[0].offset, 0);
+		memcpy(image.data(), &header, sizeof(header));
+		memcpy(image.data() + sizeof(header), sections, sizeof(sections));
+		bool written = fwrite(image.data(), 1, image.size(), file) == image.size();
+
+		const void* contents[3] = { &state, opaque.data(), transparent.data() };
+		for (int i = 0; i < 3 && written; i++)
+		{
+			uint64_t end = i < 2 ? sections[i + 1].offset : header.fileSize;
+			std::vector<uint8_t> padding(end - sections[i].offset - sections[i].size, 0);
+			written = (sections[i].size == 0 || fwrite(contents[i], 1, sections[i].size, file) == sections[i].size) &&
+				(padding.empty() || fwrite(padding.data(), 1, padding.size(), file) == padding.size());
+		}
+
+		return fclose(file) == 0 && written;
+	}
+
+	bool FrameCapture::Load(const std::string& path)
+	{
+		MappedFile file(path);
+		const uint8_t* data = file.GetData();
+		if (!data || file.GetSize() < sizeof(Header))
+		{
+			return false;
+		}
+
+		const Header& header = *(const Header*)data;
+		if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.vertexSize != sizeof(Vertex) ||
+			header.fileSize != file.GetSize() || sizeof(Header) + header.sectionCount * sizeof(Section) > file.GetSize())
+		{
+			return false;
+		}
+
+		const Section* sections = (const Section*)(data + sizeof(Header));
+		bool hasState = false;
+		opaque.clear();
+		transparent.clear();
+		for (uint32_t i = 0; i < header.sectionCount; i++)
+		{
+			const Section& section = sections[i];
+			if (section.offset > file.GetSize() || section.size > file.GetSize() - section.offset)
+			{
+				return false;
+			}
+
+			// Unknown sections are skipped, so new ones can be added without breaking older readers
+			const uint8_t* contents = data + section.offset;
+			if (section.type == State && section.size == sizeof(CaptureState))
+			{
+				memcpy(&state, contents, sizeof(CaptureState));
+				hasState = true;
+			}
+			else if ((section.type == OpaqueVertices || section.type == TransparentVertices) && section.size == (uint64_t)section.count * sizeof(Vertex))
+			{
+				std::vector<Vertex>& vertices = section.type == OpaqueVertices ? opaque : transparent;
+				vertices.resize(section.count);
+				if (section.count)
+				{
+					memcpy((void*)vertices.data(), contents, (size_t)section.size);
+				}
+			}
+		}
+
+		return hasState && IsValid(state, opaque, transparent);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Vertex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @struct CaptureState
+	 * @brief Fixed layout render state of a captured frame, stored verbatim in the file (64 bytes).
+	 */
+	struct CaptureState
+	{
+		static const uint32_t LineAntialiasing = 1;
+		static const uint32_t DiscardDepth = 2;
+
+		uint32_t width;
+		uint32_t height;
+		uint32_t tileSize;
+		/** @brief Color target element size, 4 for RGBA8, 16 for float4. */
+		uint32_t colorElementSize;
+		/** @brief TileRenderer::Topology of the opaque list. */
+		uint32_t topology;
+		uint32_t flags;
+		uint32_t transparencyBudget;
+		float pointSize;
+		float clearColor[4];
+		float clearDepth;
+		uint32_t reserved[3];
+	};
+
+	/**
+	 * @struct FrameCapture
+	 * @brief Complete input of one TileRenderer frame: state and vertex lists, see TileRenderer::CaptureNextFrame.
+	 *
+	 * The file is a 64 byte header, a section table and 64 byte aligned sections, all little endian plain old
+	 * data. Nothing needs parsing, so a mapped file is usable in place: Load maps it and copies the sections out
+	 * with one memcpy each.
+	 */
+	struct FrameCapture
+	{
+		CaptureState state;
+		std::vector<Vertex> opaque;
+		std::vector<Vertex> transparent;
+
+		/**
+		 * @return False if file cannot be written.
+		 */
+		bool Save(const std::string& path) const;
+
+		/**
+		 * @return False if file cannot be read, is not a capture of this version or its state is out of range
+		 * (empty or oversized frame, zero tile size, unknown color format or topology, vertex count not a multiple
+		 * of the primitive size).
+		 */
+		bool Load(const std::string& path);
+
+		/**
+		 * @brief Size of the file Save writes.
+		 */
+		uint64_t GetFileSize() const;
+	};
+}
@@ -0,0 +1,147 @@
+#include "LinearArena.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace Renderer
+{
+	namespace
+	{
+		const size_t BlockGranularity = 64 * 1024;
+
+		size_t RoundUp(size_t value, size_t granularity)
+		{
+			return (value + granularity - 1) / granularity * granularity;
+		}
+	}
+
+	LinearArena::LinearArena(size_t capacity)
+		: mCurrent(0), mOffset(0), mUsed(0), mHighWater(0), mSystemAllocations(0)
+	{
+		AddBlock(RoundUp(std::max<size_t>(capacity, 1), BlockGranularity));
+	}
+
+	LinearArena::~LinearArena()
+	{
+		FreeBlocks();
+	}
+
+	void LinearArena::AddBlock(size_t size)
+	{
+		Block block;
+		block.data = (uint8_t*)malloc(size);
+		block.size = size;
+		mBlocks.push_back(block);
+		mSystemAllocations++;
+	}
+
+	void LinearArena::FreeBlocks()
+	{
+		for (Block& block : mBlocks)
+		{
+			free(block.data);
+		}
+		mBlocks.clear();
+	}
+
+	void* LinearArena::Allocate(size_t size, size_t alignment)
+	{
+		for (;;)
+		{
+			Block& block = mBlocks[mCurrent];
+			uintptr_t address = (uintptr_t)block.data + mOffset;
+			size_t padding = (size_t)((alignment - (address & (alignment - 1))) & (alignment - 1));
+			if (mOffset + padding + size <= block.size)
+			{
+				mOffset += padding + size;
+				mUsed += padding + size;
+				return (void*)(address + padding);
+			}
+
+			// Rest of the block is wasted, it does not count as used, merged block on Reset has room anyway
+			mCurrent++;
+			mOffset = 0;
+			if (mCurrent == mBlocks.size())
+			{
+				AddBlock(RoundUp(std::max(size + alignment, block.size * 2), BlockGranularity));
+			}
+		}
+	}
+
+	void LinearArena::Reset()
+	{
+		mHighWater = std::max(mHighWater, mUsed);
+
+		// Frame did not fit, replace all blocks with a single one that holds the high water mark
+		if (mBlocks.size() > 1)
+		{
+			size_t capacity = RoundUp(mHighWater + mHighWater / 8, BlockGranularity);
+			FreeBlocks();
+			AddBlock(capacity);
+		}
+
+		mCurrent = 0;
+		mOffset = 0;
+		mUsed = 0;
+	}
+
+	size_t LinearArena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : mBlocks)
+		{
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	FrameArenas::FrameArenas(uint32_t threads, size_t capacity)
+	{
+		for (uint32_t i = 0; i < threads; i++)
+		{
+			mArenas.push_back(new LinearArena(capacity));
+		}
+	}
+
+	FrameArenas::~FrameArenas()
+	{
+		for (LinearArena* arena : mArenas)
+		{
+			delete arena;
+		}
+	}
+
+	void FrameArenas::Reset()
+	{
+		for (LinearArena* arena : mArenas)
+		{
+			arena->Reset();
+		}
+	}
+
+	void FrameArenas::Publish(const char* prefix)
+	{
+		if (mKeys[0].empty() || mPrefix != prefix)
+		{
+			mPrefix = prefix;
+			mKeys[0] = mPrefix + ".bytes";
+			mKeys[1] = mPrefix + ".highWater";
+			mKeys[2] = mPrefix + ".systemAllocations";
+		}
+
+		double used = 0.0;
+		double highWater = 0.0;
+		double allocations = 0.0;
+		for (const LinearArena* arena : mArenas)
+		{
+			used += (double)arena->GetUsed();
+			highWater += (double)arena->GetHighWater();
+			allocations += (double)arena->GetSystemAllocations();
+		}
+
+		Profiler& profiler = Profiler::Get();
+		profiler.Set(mKeys[0], used);
+		profiler.Set(mKeys[1], highWater);
+		profiler.Set(mKeys[2], allocations);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class LinearArena
+	 * @brief Bump allocator for frame lifetime data, everything allocated is released at once by Reset.
+	 *
+	 * Allocation is a pointer bump inside the current block. When a frame needs more than the block holds, extra
+	 * blocks are taken from the system, and the next Reset replaces them with one block sized after the high water
+	 * mark. Once the working set is known, frames run without touching new / malloc at all. Objects placed in the
+	 * arena are never destructed, so it is meant for trivially destructible data only.
+	 */
+	class LinearArena
+	{
+	protected:
+		struct Block
+		{
+			uint8_t* data;
+			size_t size;
+		};
+
+		std::vector<Block> mBlocks;
+		size_t mCurrent;
+		size_t mOffset;
+
+		size_t mUsed;
+		size_t mHighWater;
+		uint64_t mSystemAllocations;
+
+		void AddBlock(size_t size);
+		void FreeBlocks();
+
+	public:
+		/**
+		 * @param capacity Initial block size in bytes.
+		 */
+		LinearArena(size_t capacity = 64 * 1024);
+		virtual ~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/**
+		 * @brief Returns uninitialized memory valid until next Reset, alignment must be a power of two.
+		 */
+		void* Allocate(size_t size, size_t alignment = 16);
+
+		template<typename T>
+		T* Allocate(size_t count)
+		{
+			return (T*)Allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+		}
+
+		/**
+		 * @brief Releases all allocations in O(1), blocks added during the frame are merged into one.
+		 */
+		void Reset();
+
+		/** @brief Bytes allocated since last Reset, including alignment padding. */
+		size_t GetUsed() const { return mUsed; }
+		/** @brief Largest GetUsed seen at any Reset. */
+		size_t GetHighWater() const { return mHighWater; }
+		size_t GetCapacity() const;
+		/** @brief Blocks requested from the system since construction, constant in steady state. */
+		uint64_t GetSystemAllocations() const { return mSystemAllocations; }
+	};
+
+	/**
+	 * @class FrameArenas
+	 * @brief One LinearArena per ThreadPool thread, so parallel stages allocate without synchronization.
+	 */
+	class FrameArenas
+	{
+	protected:
+		std::vector<LinearArena*> mArenas;
+		/** @brief Profiler keys of the last Publish prefix, rebuilt only when the prefix changes. */
+		std::string mPrefix;
+		std::string mKeys[3];
+
+	public:
+		FrameArenas(uint32_t threads, size_t capacity = 64 * 1024);
+		virtual ~FrameArenas();
+
+		FrameArenas(const FrameArenas&) = delete;
+		FrameArenas& operator=(const FrameArenas&) = delete;
+
+		LinearArena& Get(uint32_t thread) { return *mArenas[thread]; }
+		uint32_t GetCount() const { return (uint32_t)mArenas.size(); }
+
+		/**
+		 * @brief Resets every arena, call at frame boundary when no stage holds frame data.
+		 */
+		void Reset();
+
+		/**
+		 * @brief Publishes summed usage as <prefix>.bytes, <prefix>.highWater and <prefix>.systemAllocations.
+		 */
+		void Publish(const char* prefix);
+	};
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Renderer
+{
+	/**
+	 * @class MpmcQueue
+	 * @brief Bounded lock-free multi-producer multi-consumer queue.
+	 *
+	 * Every cell carries a sequence number telling whether it is free for the producer of a given position or
+	 * holds data for the consumer of it. Producers and consumers claim positions with a CAS on their own counter
+	 * and never wait on each other unless the queue is full or empty, then TryPush / TryPop fail and the caller
+	 * decides how to back off. Capacity is rounded up to a power of two.
+	 */
+	template<typename T>
+	class MpmcQueue
+	{
+	protected:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T data;
+		};
+
+		static const size_t CacheLine = 64;
+
+		std::unique_ptr<Cell[]> mCells;
+		size_t mMask;
+
+		// Producer and consumer counters on separate cache lines
+		char mPad0[CacheLine];
+		std::atomic<size_t> mEnqueue;
+		char mPad1[CacheLine - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> mDequeue;
+		char mPad2[CacheLine - sizeof(std::atomic<size_t>)];
+
+	public:
+		MpmcQueue(size_t capacity)
+			: mEnqueue(0), mDequeue(0)
+		{
+			size_t size = 2;
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+
+			mCells.reset(new Cell[size]);
+			mMask = size - 1;
+			for (size_t i = 0; i < size; i++)
+			{
+				mCells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MpmcQueue(const MpmcQueue&) = delete;
+		MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+		/**
+		 * @return False if queue is full.
+		 */
+		bool TryPush(const T& value)
+		{
+			size_t position = mEnqueue.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				Cell& cell = mCells[position & mMask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+				if (difference == 0)
+				{
+					if (mEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						cell.data = value;
+						cell.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = mEnqueue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/**
+		 * @return False if queue is empty.
+		 */
+		bool TryPop(T& value)
+		{
+			size_t position = mDequeue.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				Cell& cell = mCells[position & mMask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+				if (difference == 0)
+				{
+					if (mDequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						value = cell.data;
+						cell.sequence.store(position + mMask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (difference < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = mDequeue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/**
+		 * @brief Number of queued elements, only a snapshot while other threads are pushing or popping.
+		 */
+		size_t GetSize() const
+		{
+			size_t enqueue = mEnqueue.load(std::memory_order_relaxed);
+			size_t dequeue = mDequeue.load(std::memory_order_relaxed);
+			return enqueue > dequeue ? enqueue - dequeue : 0;
+		}
+
+		size_t GetCapacity() const { return mMask + 1; }
+	};
+}
@@ -0,0 +1,315 @@
+#include "MultisampleBuffer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Renderer
+{
+	namespace
+	{
+		const uint32_t Compressed = 0xFFFFFFFF;
+
+		const float SamplePositions1[] = { 0.0f, 0.0f };
+
+		const float SamplePositions4[] =
+		{
+			-2.0f / 16.0f, -6.0f / 16.0f,
+			 6.0f / 16.0f, -2.0f / 16.0f,
+			-6.0f / 16.0f,  2.0f / 16.0f,
+			 2.0f / 16.0f,  6.0f / 16.0f
+		};
+
+		const float SamplePositions8[] =
+		{
+			 1.0f / 16.0f, -3.0f / 16.0f,
+			-1.0f / 16.0f,  3.0f / 16.0f,
+			 5.0f / 16.0f,  1.0f / 16.0f,
+			-3.0f / 16.0f, -5.0f / 16.0f,
+			-5.0f / 16.0f,  5.0f / 16.0f,
+			-7.0f / 16.0f, -1.0f / 16.0f,
+			 3.0f / 16.0f,  7.0f / 16.0f,
+			 7.0f / 16.0f, -7.0f / 16.0f
+		};
+	}
+
+	MultisampleBuffer::MultisampleBuffer(uint32_t width, uint32_t height, uint32_t samples, uint32_t tileSize)
+		: mGrid(width, height, tileSize), mSamples(samples), mExpandedTiles(0)
+	{
+		assert(samples == 1 || samples == 4 || samples == 8);
+		assert(tileSize && (tileSize & (tileSize - 1)) == 0);
+
+		mTileShift = 0;
+		while ((1u << mTileShift) < tileSize)
+		{
+			mTileShift++;
+		}
+
+		mFullMask = (1u << mSamples) - 1;
+		mColor.resize(width * height);
+		mDepth.resize(width * height * mSamples);
+		mTileSamples.resize(mGrid.GetTileCount(), Compressed);
+	}
+
+	const float* MultisampleBuffer::GetSamplePositions(uint32_t samples)
+	{
+		switch (samples)
+		{
+		case 4:
+			return SamplePositions4;
+		case 8:
+			return SamplePositions8;
+		default:
+			return SamplePositions1;
+		}
+	}
+
+	uint32_t* MultisampleBuffer::GetSamples(uint32_t tile, uint32_t x, uint32_t y)
+	{
+		uint32_t tileMask = mGrid.GetTileSize() - 1;
+		return &mSamplePool[mTileSamples[tile] + ((((y & tileMask) << mTileShift) + (x & tileMask)) * mSamples)];
+	}
+
+	void MultisampleBuffer::Expand(uint32_t tile)
+	{
+		uint32_t tileSize = mGrid.GetTileSize();
+		uint32_t tileStorage = tileSize * tileSize * mSamples;
+
+		// Pool only grows until it fits the worst frame seen, after that Clear just rewinds it
+		uint32_t offset = mExpandedTiles * tileStorage;
+		if (mSamplePool.size() < offset + tileStorage)
+		{
+			mSamplePool.resize(offset + tileStorage);
+		}
+		mTileSamples[tile] = offset;
+		mExpandedTiles++;
+
+		Rect r = mGrid.GetTileRect(tile);
+		for (uint32_t y = r.y; y < r.y + r.height; y++)
+		{
+			for (uint32_t x = r.x; x < r.x + r.width; x++)
+			{
+				uint32_t* samples = GetSamples(tile, x, y);
+				std::fill(samples, samples + mSamples, mColor[y * mGrid.GetWidth() + x]);
+			}
+		}
+	}
+
+	void MultisampleBuffer::Clear(uint32_t color, float depth)
+	{
+		std::fill(mColor.begin(), mColor.end(), color);
+		std::fill(mDepth.begin(), mDepth.end(), depth);
+		std::fill(mTileSamples.begin(), mTileSamples.end(), Compressed);
+		mExpandedTiles = 0;
+	}
+
+	void MultisampleBuffer::Write(uint32_t x, uint32_t y, uint32_t coverage, const float* depth, uint32_t color)
+	{
+		uint32_t mask = DepthTest(x, y, coverage, depth);
+		if (mask)
+		{
+			WriteColor(x, y, mask, color);
+		}
+	}
+
+	uint32_t MultisampleBuffer::DepthTest(uint32_t x, uint32_t y, uint32_t coverage, const float* depth)
+	{
+		uint32_t index = y * mGrid.GetWidth() + x;
+		float* stored = &mDepth[index * mSamples];
+
+		// Per sample depth test, 4 samples at once
+		uint32_t mask = 0;
+		if (mSamples == 1)
+		{
+			mask = (coverage & 1) && depth[0] < stored[0] ? 1 : 0;
+			if (mask)
+			{
+				stored[0] = depth[0];
+			}
+		}
+		else
+		{
+			__m128i bits = _mm_set_epi32(8, 4, 2, 1);
+			for (uint32_t s = 0; s < mSamples; s += 4)
+			{
+				__m128 incoming = _mm_loadu_ps(depth + s);
+				__m128 current = _mm_loadu_ps(stored + s);
+				__m128 covered = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)(coverage >> s)), bits), bits));
+				__m128 pass = _mm_and_ps(_mm_cmplt_ps(incoming, current), covered);
+				_mm_storeu_ps(stored + s, _mm_or_ps(_mm_and_ps(pass, incoming), _mm_andnot_ps(pass, current)));
+				mask |= (uint32_t)_mm_movemask_ps(pass) << s;
+			}
+		}
+		return mask;
+	}
+
+	void MultisampleBuffer::WriteColor(uint32_t x, uint32_t y, uint32_t mask, uint32_t color)
+	{
+		uint32_t index = y * mGrid.GetWidth() + x;
+		uint32_t tile = (y >> mTileShift) * mGrid.GetTilesX() + (x >> mTileShift);
+
+		if (mask == mFullMask)
+		{
+			// Fully covered pixel stays compressed
+			mColor[index] = color;
+			if (mTileSamples[tile] != Compressed)
+			{
+				uint32_t* samples = GetSamples(tile, x, y);
+				std::fill(samples, samples + mSamples, color);
+			}
+			return;
+		}
+
+		if (mTileSamples[tile] == Compressed)
+		{
+			Expand(tile);
+		}
+
+		uint32_t* samples = GetSamples(tile, x, y);
+		for (uint32_t s = 0; s < mSamples; s++)
+		{
+			if (mask & (1u << s))
+			{
+				samples[s] = color;
+			}
+		}
+	}
+
+	int MultisampleBuffer::DepthTestPacket(uint32_t x, uint32_t y, uint32_t* coverage, __m128 depth, const float* offsets)
+	{
+		// Single sample pixels are adjacent in memory, tested like a non-multisampled packet
+		if (mSamples == 1 && x + 4 <= mGrid.GetWidth())
+		{
+			float* stored = &mDepth[y * mGrid.GetWidth() + x];
+			__m128 covered = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)coverage), _mm_setzero_si128()));
+			__m128 incoming = _mm_add_ps(depth, _mm_set1_ps(offsets[0]));
+			__m128 current = _mm_loadu_ps(stored);
+			__m128 pass = _mm_and_ps(_mm_cmplt_ps(incoming, current), covered);
+			_mm_storeu_ps(stored, _mm_or_ps(_mm_and_ps(pass, incoming), _mm_andnot_ps(pass, current)));
+			_mm_storeu_si128((__m128i*)coverage, _mm_and_si128(_mm_castps_si128(pass), _mm_set1_epi32(1)));
+			return _mm_movemask_ps(pass);
+		}
+
+		float center[4];
+		_mm_storeu_ps(center, depth);
+		int mask = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (coverage[lane])
+			{
+				float samples[8];
+				samples[0] = center[lane] + offsets[0];
+				for (uint32_t s = 0; s + 4 <= mSamples; s += 4)
+				{
+					_mm_storeu_ps(samples + s, _mm_add_ps(_mm_set1_ps(center[lane]), _mm_loadu_ps(offsets + s)));
+				}
+				coverage[lane] = DepthTest(x + lane, y, coverage[lane], samples);
+				mask |= coverage[lane] ? 1 << lane : 0;
+			}
+		}
+		return mask;
+	}
+
+	void MultisampleBuffer::WriteColorPacket(uint32_t x, uint32_t y, const uint32_t* coverage, __m128i colors)
+	{
+		// Interior of a triangle within one tile, one store like a non-multisampled packet. Samples of adjacent
+		// pixels of an expanded tile are adjacent too, every pixel's samples are filled with its color
+		uint32_t last = x + 3;
+		__m128i full = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)coverage), _mm_set1_epi32((int)mFullMask));
+		if (last < mGrid.GetWidth() && _mm_movemask_ps(_mm_castsi128_ps(full)) == 0xF && (x >> mTileShift) == (last >> mTileShift))
+		{
+			_mm_storeu_si128((__m128i*)&mColor[y * mGrid.GetWidth() + x], colors);
+
+			uint32_t tile = (y >> mTileShift) * mGrid.GetTilesX() + (x >> mTileShift);
+			if (mTileSamples[tile] != Compressed && mSamples > 1)
+			{
+				__m128i* samples = (__m128i*)GetSamples(tile, x, y);
+				__m128i spread[4] =
+				{
+					_mm_shuffle_epi32(colors, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_epi32(colors, _MM_SHUFFLE(1, 1, 1, 1)),
+					_mm_shuffle_epi32(colors, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_epi32(colors, _MM_SHUFFLE(3, 3, 3, 3))
+				};
+				for (uint32_t i = 0; i < mSamples; i++)
+				{
+					_mm_storeu_si128(samples + i, spread[i * 4 / mSamples]);
+				}
+			}
+			return;
+		}
+
+		uint32_t pixels[4];
+		_mm_storeu_si128((__m128i*)pixels, colors);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (coverage[lane])
+			{
+				WriteColor(x + lane, y, coverage[lane], pixels[lane]);
+			}
+		}
+	}
+
+	void MultisampleBuffer::Resolve(Buffer& target) const
+	{
+		assert(target.GetElementSize() == 4 && target.GetElementCount() == mGrid.GetWidth() * mGrid.GetHeight());
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		uint32_t* output = (uint32_t*)target.GetData();
+		uint32_t width = mGrid.GetWidth();
+		uint32_t tileSize = mGrid.GetTileSize();
+		uint32_t shift = mSamples == 8 ? 3 : (mSamples == 4 ? 2 : 0);
+		__m128i zero = _mm_setzero_si128();
+		__m128i round = _mm_set1_epi16((short)(mSamples / 2));
+
+		for (uint32_t tile = 0; tile < mGrid.GetTileCount(); tile++)
+		{
+			Rect r = mGrid.GetTileRect(tile);
+
+			// All samples equal, resolve is a plain copy
+			if (mTileSamples[tile] == Compressed)
+			{
+				for (uint32_t y = r.y; y < r.y + r.height; y++)
+				{
+					memcpy(&output[y * width + r.x], &mColor[y * width + r.x], r.width * sizeof(uint32_t));
+				}
+				continue;
+			}
+
+			for (uint32_t y = r.y; y < r.y + r.height; y++)
+			{
+				const uint32_t* samples = &mSamplePool[mTileSamples[tile] + (y % tileSize) * tileSize * mSamples];
+				for (uint32_t x = 0; x < r.width; x++, samples += mSamples)
+				{
+					// Widen RGBA8 samples to 16 bit lanes and sum, 8 samples * 255 still fits
+					__m128i sum = zero;
+					for (uint32_t s = 0; s < mSamples; s += 4)
+					{
+						__m128i v = _mm_loadu_si128((const __m128i*)(samples + s));
+						sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)));
+					}
+					sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+					sum = _mm_srli_epi16(_mm_add_epi16(sum, round), (int)shift);
+					output[y * width + r.x + x] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(sum, zero));
+				}
+			}
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		Profiler::Get().Set("msaa.samples", mSamples);
+		Profiler::Get().Set("msaa.memoryBytes", (double)GetMemoryFootprint());
+		Profiler::Get().Set("msaa.expandedTiles", mExpandedTiles);
+		Profiler::Get().Set("msaa.resolveMPixelsPerSecond", seconds > 0.0 ? (width * mGrid.GetHeight()) / seconds * 1e-6 : 0.0);
+	}
+
+	size_t MultisampleBuffer::GetMemoryFootprint() const
+	{
+		uint32_t tileSize = mGrid.GetTileSize();
+		return mColor.size() * sizeof(uint32_t) +
+			mDepth.size() * sizeof(float) +
+			mTileSamples.size() * sizeof(uint32_t) +
+			(size_t)mExpandedTiles * tileSize * tileSize * mSamples * sizeof(uint32_t);
+	}
+}
\ No newline at end of file
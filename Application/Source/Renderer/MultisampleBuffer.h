@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Buffer.h"
+#include "TileGrid.h"
+#include <cstddef>
+#include <emmintrin.h>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class MultisampleBuffer
+	 * @brief Multisampled color and depth target (1x, 4x or 8x).
+	 *
+	 * Coverage and depth are evaluated per sample, color is shaded once per pixel and written to every
+	 * covered sample. Color is stored compressed per tile - as long as every pixel in a tile has all samples
+	 * equal only one color per pixel is kept. The first partially covered write into a tile expands it into
+	 * full per-sample storage taken from a pool that is recycled on Clear.
+	 */
+	class MultisampleBuffer
+	{
+	protected:
+		TileGrid mGrid;
+		uint32_t mSamples;
+		uint32_t mFullMask;
+		/** @brief log2 of tile size, pixel to tile lookups are shifts and masks. */
+		uint32_t mTileShift;
+
+		std::vector<uint32_t> mColor;
+		std::vector<float> mDepth;
+		std::vector<uint32_t> mTileSamples;
+		std::vector<uint32_t> mSamplePool;
+		uint32_t mExpandedTiles;
+
+		uint32_t* GetSamples(uint32_t tile, uint32_t x, uint32_t y);
+		void Expand(uint32_t tile);
+
+	public:
+		MultisampleBuffer(uint32_t width, uint32_t height, uint32_t samples, uint32_t tileSize = 16);
+
+		/**
+		 * @brief Gets sample offsets from pixel center (x, y pairs in pixels), standard D3D patterns.
+		 */
+		static const float* GetSamplePositions(uint32_t samples);
+
+		void Clear(uint32_t color, float depth);
+
+		/**
+		 * @brief Depth tests and writes single shaded color into covered samples of a pixel.
+		 * @param coverage Bit per sample, set if the sample lies inside the primitive.
+		 * @param depth Depth interpolated at each sample position.
+		 * @param color Shaded RGBA8 color.
+		 */
+		void Write(uint32_t x, uint32_t y, uint32_t coverage, const float* depth, uint32_t color);
+
+		/**
+		 * @brief First half of Write, depth tests covered samples and writes depth of the passing ones, lets
+		 * occluded pixels skip shading.
+		 * @return Mask of samples that passed.
+		 */
+		uint32_t DepthTest(uint32_t x, uint32_t y, uint32_t coverage, const float* depth);
+
+		/**
+		 * @brief Second half of Write, writes color into samples that passed DepthTest.
+		 */
+		void WriteColor(uint32_t x, uint32_t y, uint32_t mask, uint32_t color);
+
+		/**
+		 * @brief DepthTest of 4 horizontally adjacent pixels starting at (x, y), sample s of lane i has depth
+		 * depth[i] + offsets[s]. Single sample pixels are tested 4 at once.
+		 * @param coverage Covered samples per lane, replaced by the samples that passed.
+		 * @return Mask of lanes with any sample passed.
+		 */
+		int DepthTestPacket(uint32_t x, uint32_t y, uint32_t* coverage, __m128 depth, const float* offsets);
+
+		/**
+		 * @brief WriteColor of 4 horizontally adjacent pixels, fully covered ones inside a compressed tile are
+		 * stored at once.
+		 */
+		void WriteColorPacket(uint32_t x, uint32_t y, const uint32_t* coverage, __m128i colors);
+
+		/**
+		 * @brief Averages samples into a width x height RGBA8 buffer.
+		 */
+		void Resolve(Buffer& target) const;
+
+		/**
+		 * @brief Gets bytes currently used for color, depth and expanded sample storage.
+		 */
+		size_t GetMemoryFootprint() const;
+
+		uint32_t GetSampleCount() const { return mSamples; }
+		uint32_t GetExpandedTileCount() const { return mExpandedTiles; }
+		const TileGrid& GetGrid() const { return mGrid; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "OutputStage.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Renderer
+{
+	namespace
+	{
+		const uint32_t RowsPerTask = 16;
+
+		const float Bayer[4][4] =
+		{
+			{  0.0f,  8.0f,  2.0f, 10.0f },
+			{ 12.0f,  4.0f, 14.0f,  6.0f },
+			{  3.0f, 11.0f,  1.0f,  9.0f },
+			{ 15.0f,  7.0f, 13.0f,  5.0f }
+		};
+
+		inline __m128 Saturate(__m128 c)
+		{
+			return _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		}
+
+		inline __m128 Reinhard(__m128 c)
+		{
+			return _mm_div_ps(c, _mm_add_ps(c, _mm_set1_ps(1.0f)));
+		}
+
+		/**
+		 * @brief Narkowicz fit of ACES filmic curve.
+		 */
+		inline __m128 ACES(__m128 c)
+		{
+			__m128 numerator = _mm_mul_ps(c, _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(2.51f)), _mm_set1_ps(0.03f)));
+			__m128 denominator = _mm_add_ps(_mm_mul_ps(c, _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(2.43f)), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f));
+			return _mm_div_ps(numerator, denominator);
+		}
+
+		/**
+		 * @brief Linear to sRGB, pow(c, 1 / 2.4) approximated by polynomial in c^(1/2), c^(1/4) and c^(1/8).
+		 */
+		inline __m128 LinearToSRGB(__m128 c)
+		{
+			__m128 s1 = _mm_sqrt_ps(c);
+			__m128 s2 = _mm_sqrt_ps(s1);
+			__m128 s3 = _mm_sqrt_ps(s2);
+			__m128 curve = _mm_mul_ps(s1, _mm_set1_ps(0.662002687f));
+			curve = _mm_add_ps(curve, _mm_mul_ps(s2, _mm_set1_ps(0.684122060f)));
+			curve = _mm_sub_ps(curve, _mm_mul_ps(s3, _mm_set1_ps(0.323583601f)));
+			curve = _mm_sub_ps(curve, _mm_mul_ps(c, _mm_set1_ps(0.0225411470f)));
+
+			__m128 linear = _mm_mul_ps(c, _mm_set1_ps(12.92f));
+			__m128 mask = _mm_cmple_ps(c, _mm_set1_ps(0.0031308f));
+			return _mm_or_ps(_mm_and_ps(mask, linear), _mm_andnot_ps(mask, curve));
+		}
+
+		inline __m128i Quantize(__m128 c, __m128 dither)
+		{
+			__m128 v = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), dither);
+			v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+			return _mm_cvttps_epi32(v);
+		}
+	}
+
+	OutputStage::OutputStage(ThreadPool* pool)
+		: mPool(pool), mTonemap(Tonemap::ACES), mExposure(1.0f), mDither(true)
+	{
+	}
+
+	void OutputStage::ProcessRow(const float* source, uint32_t* destination, uint32_t count, uint32_t x, uint32_t y) const
+	{
+		__m128 exposure = _mm_set1_ps(mExposure);
+
+		// Rounding offset plus ordered dither in [-0.5, 0.5) of a quantization step, same phase for every 4 pixels
+		__m128 dither = _mm_set1_ps(0.5f);
+		if (mDither)
+		{
+			const float* bayer = Bayer[y & 3];
+			dither = _mm_add_ps(dither, _mm_sub_ps(_mm_mul_ps(_mm_set_ps(bayer[(x + 3) & 3], bayer[(x + 2) & 3], bayer[(x + 1) & 3], bayer[x & 3]), _mm_set1_ps(1.0f / 16.0f)), _mm_set1_ps(15.0f / 32.0f)));
+		}
+
+		float tail[16];
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			const float* pixels = source + i * 4;
+			uint32_t valid = count - i < 4 ? count - i : 4;
+			if (valid < 4)
+			{
+				memset(tail, 0, sizeof(tail));
+				memcpy(tail, pixels, valid * 4 * sizeof(float));
+				pixels = tail;
+			}
+
+			// AoS to SoA, one register per channel of 4 pixels
+			__m128 r = _mm_loadu_ps(pixels);
+			__m128 g = _mm_loadu_ps(pixels + 4);
+			__m128 b = _mm_loadu_ps(pixels + 8);
+			__m128 a = _mm_loadu_ps(pixels + 12);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			r = _mm_mul_ps(r, exposure);
+			g = _mm_mul_ps(g, exposure);
+			b = _mm_mul_ps(b, exposure);
+
+			switch (mTonemap)
+			{
+			case Tonemap::Reinhard:
+				r = Reinhard(r);
+				g = Reinhard(g);
+				b = Reinhard(b);
+				break;
+			case Tonemap::ACES:
+				r = ACES(r);
+				g = ACES(g);
+				b = ACES(b);
+				break;
+			default:
+				break;
+			}
+
+			r = LinearToSRGB(Saturate(r));
+			g = LinearToSRGB(Saturate(g));
+			b = LinearToSRGB(Saturate(b));
+
+			__m128i packed = Quantize(r, dither);
+			packed = _mm_or_si128(packed, _mm_slli_epi32(Quantize(g, dither), 8));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(Quantize(b, dither), 16));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(Quantize(Saturate(a), _mm_set1_ps(0.5f)), 24));
+
+			if (valid == 4)
+			{
+				_mm_storeu_si128((__m128i*)(destination + i), packed);
+			}
+			else
+			{
+				uint32_t result[4];
+				_mm_storeu_si128((__m128i*)result, packed);
+				memcpy(destination + i, result, valid * sizeof(uint32_t));
+			}
+		}
+	}
+
+	void OutputStage::Process(const Buffer& hdr, uint32_t width, const Rect& rect, void* destination, uint32_t destinationPitch) const
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		const float* source = (const float*)hdr.GetData();
+		uint32_t tasks = (rect.height + RowsPerTask - 1) / RowsPerTask;
+
+		auto task = [&](uint32_t index, uint32_t)
+		{
+			uint32_t first = index * RowsPerTask;
+			uint32_t last = first + RowsPerTask < rect.height ? first + RowsPerTask : rect.height;
+			for (uint32_t row = first; row < last; row++)
+			{
+				uint32_t y = rect.y + row;
+				ProcessRow(source + ((size_t)y * width + rect.x) * 4, (uint32_t*)((uint8_t*)destination + (size_t)row * destinationPitch), rect.width, rect.x, y);
+			}
+		};
+
+		if (mPool)
+		{
+			mPool->ParallelFor(tasks, task);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < tasks; i++)
+			{
+				task(i, 0);
+			}
+		}
+
+		Profiler::Get().Add("output.ms", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		Profiler::Get().Add("output.pixels", (double)rect.width * rect.height);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Buffer.h"
+#include "ThreadPool.h"
+#include "TileGrid.h"
+
+namespace Renderer
+{
+	enum class Tonemap
+	{
+		Clamp,
+		Reinhard,
+		ACES
+	};
+
+	/**
+	 * @class OutputStage
+	 * @brief Converts HDR float4 target into presentable RGBA8.
+	 *
+	 * Exposure, tonemapping, linear to sRGB encoding (sqrt based polynomial instead of pow), optional 4x4 ordered
+	 * dithering and packing are done in a single SSE pass over 4 pixels at a time, rows are split across the
+	 * thread pool. Destination is arbitrary memory with its own pitch, so the stage can write straight into the
+	 * presentation upload buffer and every HDR pixel is read exactly once.
+	 */
+	class OutputStage
+	{
+	protected:
+		ThreadPool* mPool;
+		Tonemap mTonemap;
+		float mExposure;
+		bool mDither;
+
+		void ProcessRow(const float* source, uint32_t* destination, uint32_t count, uint32_t x, uint32_t y) const;
+
+	public:
+		/**
+		 * @param pool Pool to split rows across, null processes on calling thread.
+		 */
+		OutputStage(ThreadPool* pool = nullptr);
+
+		void SetTonemap(Tonemap tonemap) { mTonemap = tonemap; }
+		void SetExposure(float exposure) { mExposure = exposure; }
+		void SetDither(bool dither) { mDither = dither; }
+
+		/**
+		 * @brief Converts rectangle of HDR buffer.
+		 * @param hdr Buffer of float4 elements, width pixels per row.
+		 * @param destination RGBA8 output for the rectangle, its first pixel is rect.x, rect.y.
+		 * @param destinationPitch Bytes between destination rows.
+		 */
+		void Process(const Buffer& hdr, uint32_t width, const Rect& rect, void* destination, uint32_t destinationPitch) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "Profiler.h"
+
+namespace Renderer
+{
+	Profiler& Profiler::Get()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	void Profiler::Set(const char* name, double value)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mValues.find(name);
+		if (it != mValues.end())
+		{
+			it->second = value;
+			return;
+		}
+		mValues.emplace(name, value);
+	}
+
+	void Profiler::Add(const char* name, double value)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mValues.find(name);
+		if (it != mValues.end())
+		{
+			it->second += value;
+			return;
+		}
+		mValues.emplace(name, value);
+	}
+
+	double Profiler::GetValue(const char* name) const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mValues.find(name);
+		return it != mValues.end() ? it->second : 0.0;
+	}
+
+	void Profiler::Reset()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mValues.clear();
+	}
+
+	void Profiler::Report(std::ostream& stream) const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& value : mValues)
+		{
+			stream << value.first << " = " << value.second << std::endl;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace Renderer
+{
+	/**
+	 * @class Profiler
+	 * @brief Named per-frame counters reported by the renderer stages.
+	 *
+	 * Stages publish their totals once per frame (not per pixel), so a mutex protected map is cheap enough. Keys
+	 * are looked up without building a std::string, so publishing a counter that already exists does not allocate.
+	 */
+	class Profiler
+	{
+	protected:
+		mutable std::mutex mMutex;
+		std::map<std::string, double, std::less<>> mValues;
+
+	public:
+		static Profiler& Get();
+
+		void Set(const char* name, double value);
+		void Add(const char* name, double value);
+		double GetValue(const char* name) const;
+
+		void Set(const std::string& name, double value) { Set(name.c_str(), value); }
+		void Add(const std::string& name, double value) { Add(name.c_str(), value); }
+		double GetValue(const std::string& name) const { return GetValue(name.c_str()); }
+
+		void Reset();
+		void Report(std::ostream& stream) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,969 @@
+#include "Rasterizer.h"
+#include "Color.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Renderer
+{
+	using Math::Numeric::float4;
+
+	namespace
+	{
+		inline int64_t Snap(float coordinate)
+		{
+			return _mm_cvtss_si32(_mm_set_ss(coordinate * Rasterizer::SubpixelScale));
+		}
+
+		/**
+		 * @brief Vertex attributes in Interpolants order: depth, color, texcoord.
+		 */
+		inline void GetAttributes(const Vertex& v, float* attributes)
+		{
+			attributes[0] = v.position.z;
+			for (int i = 0; i < 4; i++)
+			{
+				attributes[1 + i] = v.color[i];
+				attributes[5 + i] = v.texcoord[i];
+			}
+		}
+
+		/**
+		 * @brief floorf converted to int without a library call (SSE2 has no rounding instruction).
+		 */
+		inline int FloorToInt(float value)
+		{
+			int truncated = (int)value;
+			return truncated - ((float)truncated > value ? 1 : 0);
+		}
+
+		/**
+		 * @brief Four lane floor converted to int, truncation rounds negative values up so it is corrected.
+		 */
+		inline __m128i FloorToInt(__m128 value)
+		{
+			__m128i truncated = _mm_cvttps_epi32(value);
+			return _mm_add_epi32(truncated, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value)));
+		}
+
+		inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		inline __m128i Min(__m128i a, __m128i b)
+		{
+			return Select(_mm_cmplt_epi32(a, b), a, b);
+		}
+
+		inline __m128i Max(__m128i a, __m128i b)
+		{
+			return Select(_mm_cmpgt_epi32(a, b), a, b);
+		}
+
+		/**
+		 * @brief Low 32 bits of a * b per lane (SSE2 has no 32-bit multiply).
+		 */
+		inline __m128i MultiplyLow(__m128i a, uint32_t b)
+		{
+			__m128i factor = _mm_set1_epi32((int)b);
+			__m128i even = _mm_mul_epu32(a, factor);
+			__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), factor);
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		/**
+		 * @brief Splats every component of value to its own register.
+		 */
+		inline void Broadcast(__m128 value, __m128* components)
+		{
+			components[0] = _mm_shuffle_ps(value, value, _MM_SHUFFLE(0, 0, 0, 0));
+			components[1] = _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1));
+			components[2] = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2));
+			components[3] = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+
+		/**
+		 * @brief Same clamp and rounding as PackPacket for one RGBA register per lane, already in RGBA byte order.
+		 */
+		inline void PackPixels(const __m128* pixels, uint32_t* bytes)
+		{
+			__m128 zero = _mm_setzero_ps();
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 scale = _mm_set1_ps(255.0f);
+			__m128 round = _mm_set1_ps(0.5f);
+			__m128i packed[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				packed[lane] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(pixels[lane], zero), one), scale), round));
+			}
+			_mm_storeu_si128((__m128i*)bytes, _mm_packus_epi16(_mm_packs_epi32(packed[0], packed[1]), _mm_packs_epi32(packed[2], packed[3])));
+		}
+
+		/**
+		 * @brief First and last pixel whose center lies in [start, end), first > last if there is none.
+		 */
+		inline void PixelRange(float start, float end, int& first, int& last)
+		{
+			first = -FloorToInt(0.5f - start);
+			last = -FloorToInt(0.5f - end) - 1;
+		}
+	}
+
+	Rasterizer::Rasterizer(Buffer* color, Buffer* depth, uint32_t width, uint32_t height)
+		: mColor(color), mDepth(depth), mWidth(width), mHeight(height), mOriginX(0), mOriginY(0), mSmallTrianglePath(true),
+		mLineAntialiasing(false), mPointSize(1.0f), mFragments(nullptr), mMultisample(nullptr), mSampleReach(0)
+	{
+		mScissor.x = 0;
+		mScissor.y = 0;
+		mScissor.width = width;
+		mScissor.height = height;
+		ResetStatistics();
+	}
+
+	void Rasterizer::SetScissor(const Rect& scissor)
+	{
+		mScissor = scissor;
+	}
+
+	void Rasterizer::SetMultisampleBuffer(MultisampleBuffer* target)
+	{
+		mMultisample = target;
+		mSampleReach = 0;
+		if (!target)
+		{
+			return;
+		}
+
+		const float* positions = MultisampleBuffer::GetSamplePositions(target->GetSampleCount());
+		for (uint32_t i = 0; i < target->GetSampleCount() * 2; i++)
+		{
+			mSampleReach = std::max(mSampleReach, (int)fabsf(positions[i] * SubpixelScale));
+		}
+	}
+
+	void Rasterizer::SetOrigin(int x, int y)
+	{
+		mOriginX = x;
+		mOriginY = y;
+	}
+
+	void Rasterizer::SetupSpan(const float* start, const float* step, Interpolants& ip) const
+	{
+		for (int i = 0; i < Interpolants::Count; i++)
+		{
+			ip.base[i] = _mm_set1_ps(start[i]);
+			ip.d1[i] = _mm_set1_ps(step[i]);
+			ip.d2[i] = _mm_setzero_ps();
+		}
+	}
+
+	void Rasterizer::DrawSpan(const Interpolants& ip, int y, int x0, int x1, float origin)
+	{
+		// Span is a degenerate triangle setup: weight 1 is the distance of pixel center from origin, weight 2 is unused
+		Setup s;
+		s.invArea = 1.0f;
+
+		// Multisampled, span pixels cover all their samples at the span's depth
+		SamplePlanes planes;
+		uint32_t fullMask = 0;
+		if (mMultisample)
+		{
+			std::fill(planes.depth, planes.depth + 8, 0.0f);
+			fullMask = (1u << mMultisample->GetSampleCount()) - 1;
+		}
+
+		__m128 centers = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		__m128 start = _mm_set1_ps(origin);
+		for (int x = x0; x <= x1; x += 4)
+		{
+			int mask = (1 << std::min(x1 - x + 1, 4)) - 1;
+			__m128 offset = _mm_sub_ps(_mm_add_ps(_mm_set1_ps((float)x), centers), start);
+			if (mMultisample)
+			{
+				uint32_t coverage[4];
+				for (int lane = 0; lane < 4; lane++)
+				{
+					coverage[lane] = mask & (1 << lane) ? fullMask : 0;
+				}
+				ShadeMultisample(s, ip, planes, x, y, coverage, offset, _mm_setzero_ps(), VertexColorShader());
+				continue;
+			}
+			ShadePacket(s, ip, x, y, mask, offset, _mm_setzero_ps(), VertexColorShader());
+		}
+	}
+
+	void Rasterizer::DrawLine(const Vertex& v0, const Vertex& v1)
+	{
+		Vertex line[2] = { v0, v1 };
+		DrawLines(line, nullptr, 1);
+	}
+
+	void Rasterizer::DrawLines(const Vertex* vertices, const uint32_t* offsets, uint32_t count)
+	{
+		mStatistics.lines += count;
+
+		if (mLineAntialiasing)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const Vertex* v = vertices + (offsets ? offsets[i] : 2 * i);
+				float a[Interpolants::Count];
+				float b[Interpolants::Count];
+				GetAttributes(v[0], a);
+				GetAttributes(v[1], b);
+				DrawLineAntialiased(a, b, v[0].position.x - mOriginX, v[0].position.y - mOriginY, v[1].position.x - mOriginX,
+					v[1].position.y - mOriginY);
+			}
+			return;
+		}
+
+		__m128 originX = _mm_set1_ps((float)mOriginX);
+		__m128 originY = _mm_set1_ps((float)mOriginY);
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 sign = _mm_set1_ps(-0.0f);
+		__m128i scissorX0 = _mm_set1_epi32((int)mScissor.x);
+		__m128i scissorY0 = _mm_set1_epi32((int)mScissor.y);
+		__m128i scissorX1 = _mm_set1_epi32((int)(mScissor.x + mScissor.width) - 1);
+		__m128i scissorY1 = _mm_set1_epi32((int)(mScissor.y + mScissor.height) - 1);
+		__m128 centers = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		__m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+		for (uint32_t group = 0; group < count; group += 4)
+		{
+			// Setup of four lines at once, same operations as one line at a time so results do not depend on
+			// grouping. A short group repeats its last line in the unused lanes.
+			const Vertex* v[4];
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				uint32_t i = std::min(group + k, count - 1);
+				v[k] = vertices + (offsets ? offsets[i] : 2 * i);
+			}
+
+			__m128 ax = _mm_loadu_ps(&v[0][0].position.x);
+			__m128 ay = _mm_loadu_ps(&v[1][0].position.x);
+			__m128 az = _mm_loadu_ps(&v[2][0].position.x);
+			__m128 aw = _mm_loadu_ps(&v[3][0].position.x);
+			_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+			__m128 bx = _mm_loadu_ps(&v[0][1].position.x);
+			__m128 by = _mm_loadu_ps(&v[1][1].position.x);
+			__m128 bz = _mm_loadu_ps(&v[2][1].position.x);
+			__m128 bw = _mm_loadu_ps(&v[3][1].position.x);
+			_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+			ax = _mm_sub_ps(ax, originX);
+			ay = _mm_sub_ps(ay, originY);
+			bx = _mm_sub_ps(bx, originX);
+			by = _mm_sub_ps(by, originY);
+
+			__m128 steep = _mm_cmpgt_ps(_mm_andnot_ps(sign, _mm_sub_ps(by, ay)), _mm_andnot_ps(sign, _mm_sub_ps(bx, ax)));
+			__m128i steepLanes = _mm_castps_si128(steep);
+			__m128 major0 = Select(steep, ay, ax);
+			__m128 major1 = Select(steep, by, bx);
+			__m128 minor0 = Select(steep, ax, ay);
+			__m128 minor1 = Select(steep, bx, by);
+
+			// Pixel centers in [start, end) along the major axis inside the scissor
+			__m128i first = _mm_sub_epi32(_mm_setzero_si128(), FloorToInt(_mm_sub_ps(half, _mm_min_ps(major0, major1))));
+			__m128i last = _mm_sub_epi32(_mm_set1_epi32(-1), FloorToInt(_mm_sub_ps(half, _mm_max_ps(major0, major1))));
+			first = Max(first, Select(steepLanes, scissorY0, scissorX0));
+			last = Min(last, Select(steepLanes, scissorY1, scissorX1));
+			__m128i minorMin = Select(steepLanes, scissorX0, scissorY0);
+			__m128i minorMax = Select(steepLanes, scissorX1, scissorY1);
+
+			// Minor coordinate from the fractional part only, so results do not depend on origin and tiles match
+			// immediate rendering exactly. Lines ending within a pixel of the minor scissor edges need clipping.
+			__m128 dt = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sub_ps(major1, major0));
+			__m128 minorBase = _mm_cvtepi32_ps(FloorToInt(minor0));
+			__m128i edge = _mm_or_si128(_mm_cmplt_epi32(FloorToInt(_mm_min_ps(minor0, minor1)), _mm_add_epi32(minorMin, _mm_set1_epi32(1))),
+				_mm_cmpgt_epi32(FloorToInt(_mm_max_ps(minor0, minor1)), _mm_sub_epi32(minorMax, _mm_set1_epi32(1))));
+
+			struct
+			{
+				float major0[4];
+				float dt[4];
+				float slope[4];
+				float minorBase[4];
+				float minorFraction[4];
+				float depthStep[4];
+				int first[4];
+				int last[4];
+				int minorMin[4];
+				int minorMax[4];
+			} lines;
+			_mm_storeu_ps(lines.major0, major0);
+			_mm_storeu_ps(lines.dt, dt);
+			_mm_storeu_ps(lines.slope, _mm_mul_ps(_mm_sub_ps(minor1, minor0), dt));
+			_mm_storeu_ps(lines.minorBase, minorBase);
+			_mm_storeu_ps(lines.minorFraction, _mm_sub_ps(minor0, minorBase));
+			_mm_storeu_ps(lines.depthStep, _mm_mul_ps(_mm_sub_ps(bz, az), dt));
+			_mm_storeu_si128((__m128i*)lines.first, first);
+			_mm_storeu_si128((__m128i*)lines.last, last);
+			_mm_storeu_si128((__m128i*)lines.minorMin, minorMin);
+			_mm_storeu_si128((__m128i*)lines.minorMax, minorMax);
+			int steepMask = _mm_movemask_ps(steep);
+			int degenerateMask = _mm_movemask_ps(_mm_cmpeq_ps(major0, major1));
+			int edgeMask = _mm_movemask_ps(_mm_castsi128_ps(edge));
+
+			for (uint32_t k = 0; k < 4 && group + k < count; k++)
+			{
+				if (degenerateMask & (1 << k))
+				{
+					mStatistics.degenerate++;
+					continue;
+				}
+
+				// Pixel m lands on minor minorBase + floor(minorFraction + (m + 0.5 - major0) * slope). Near the
+				// minor scissor edges the major range inside it is solved directly, with a pixel of margin for
+				// rounding, so tiles a line only passes near cost no stepping.
+				int firstStep = lines.first[k];
+				int lastStep = lines.last[k];
+				float slope = lines.slope[k];
+				float base = lines.minorBase[k];
+				float fraction = lines.minorFraction[k];
+				if ((edgeMask & (1 << k)) && firstStep <= lastStep)
+				{
+					if (slope != 0.0f)
+					{
+						double low = (lines.minorMin[k] - (double)base - fraction) / slope + lines.major0[k] - 0.5;
+						double high = (lines.minorMax[k] + 1.0 - base - fraction) / slope + lines.major0[k] - 0.5;
+						firstStep = std::max(firstStep, (int)std::max(floor(std::min(low, high)) - 1.0, (double)firstStep - 1.0));
+						lastStep = std::min(lastStep, (int)std::min(ceil(std::max(low, high)) + 1.0, (double)lastStep + 1.0));
+					}
+					else if (base < lines.minorMin[k] || base > lines.minorMax[k])
+					{
+						firstStep = lastStep + 1;
+					}
+				}
+				if (firstStep > lastStep)
+				{
+					mStatistics.culled++;
+					continue;
+				}
+
+				// Lines are shaded with vertex color, so depth and color step per pixel along major axis from the
+				// first vertex and texture coordinates are not set up
+				float depth = v[k][0].position.z;
+				float depthStep = lines.depthStep[k];
+				__m128 color = _mm_loadu_ps(&v[k][0].color.x);
+				__m128 colorStep = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&v[k][1].color.x), color), _mm_set1_ps(lines.dt[k]));
+
+				// Four steps along the major axis per packet, each lane addressed on its own so steep and diagonal
+				// runs fill whole packets too
+				bool isSteep = (steepMask & (1 << k)) != 0;
+				__m128 origin = _mm_set1_ps(lines.major0[k]);
+				__m128 fractions = _mm_set1_ps(fraction);
+				__m128 slopes = _mm_set1_ps(slope);
+				__m128i bases = _mm_set1_epi32((int)base);
+				__m128i below = _mm_set1_epi32(lines.minorMin[k]);
+				__m128i above = _mm_set1_epi32(lines.minorMax[k]);
+				for (int m = firstStep; m <= lastStep; m += 4)
+				{
+					__m128 offset = _mm_sub_ps(_mm_add_ps(_mm_set1_ps((float)m), centers), origin);
+					__m128i rows = _mm_add_epi32(FloorToInt(_mm_add_ps(fractions, _mm_mul_ps(offset, slopes))), bases);
+					__m128i outside = _mm_or_si128(_mm_cmplt_epi32(rows, below), _mm_cmpgt_epi32(rows, above));
+					__m128i inside = _mm_andnot_si128(outside, _mm_cmplt_epi32(lanes, _mm_set1_epi32(lastStep - m + 1)));
+					int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+
+					if (mask)
+					{
+						// Masked lanes may point outside the target, they address pixel 0 instead
+						__m128i majors = _mm_add_epi32(_mm_set1_epi32(m), lanes);
+						__m128i x = isSteep ? rows : majors;
+						__m128i y = isSteep ? majors : rows;
+						uint32_t index[4];
+						_mm_storeu_si128((__m128i*)index, _mm_and_si128(_mm_add_epi32(MultiplyLow(y, mWidth), x), inside));
+						ShadeScattered(index, mask, offset, depth, depthStep, color, colorStep);
+					}
+				}
+			}
+		}
+	}
+
+	void Rasterizer::ShadeScattered(const uint32_t* index, int mask, __m128 offset, float depth, float depthStep, __m128 color,
+		__m128 colorStep)
+	{
+		// Same arithmetic as ShadePacket on a span setup (unit area, zero second weight), so line pixels match
+		// what spans would produce bit for bit. Color is kept one vector per lane, ready to store.
+		__m128 zero = _mm_setzero_ps();
+		__m128 z = _mm_add_ps(_mm_set1_ps(depth), _mm_add_ps(_mm_mul_ps(offset, _mm_set1_ps(depthStep)), zero));
+
+		if (mDepth && !mMultisample)
+		{
+			float* target = (float*)mDepth->GetData();
+			__m128 stored = _mm_set_ps(target[index[3]], target[index[2]], target[index[1]], target[index[0]]);
+			mask &= _mm_movemask_ps(_mm_cmplt_ps(z, stored));
+			if (!mask)
+			{
+				return;
+			}
+
+			if (!mFragments)
+			{
+				float values[4];
+				_mm_storeu_ps(values, z);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (mask & (1 << lane))
+					{
+						target[index[lane]] = values[lane];
+					}
+				}
+			}
+		}
+
+		__m128 pixels[4];
+		pixels[0] = _mm_add_ps(color, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(offset, offset, _MM_SHUFFLE(0, 0, 0, 0)), colorStep), zero));
+		pixels[1] = _mm_add_ps(color, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(offset, offset, _MM_SHUFFLE(1, 1, 1, 1)), colorStep), zero));
+		pixels[2] = _mm_add_ps(color, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(offset, offset, _MM_SHUFFLE(2, 2, 2, 2)), colorStep), zero));
+		pixels[3] = _mm_add_ps(color, _mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(offset, offset, _MM_SHUFFLE(3, 3, 3, 3)), colorStep), zero));
+
+		if (mMultisample)
+		{
+			// A line pixel covers all its samples, depth test and write are the multisampled target's
+			uint32_t fullMask = (1u << mMultisample->GetSampleCount()) - 1;
+			uint32_t bytes[4];
+			PackPixels(pixels, bytes);
+			float values[4];
+			_mm_storeu_ps(values, z);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					float depths[8];
+					std::fill(depths, depths + 8, values[lane]);
+					uint32_t x = index[lane] % mWidth;
+					uint32_t y = index[lane] / mWidth;
+					uint32_t passed = mMultisample->DepthTest(x, y, fullMask, depths);
+					if (passed)
+					{
+						mMultisample->WriteColor(x, y, passed, bytes[lane]);
+					}
+					else
+					{
+						mask &= ~(1 << lane);
+					}
+				}
+			}
+		}
+		else if (mFragments)
+		{
+			// Insert addresses lane k at index + k, one call per lane with the index shifted back
+			PacketFloat4 result;
+			result.x = pixels[0];
+			result.y = pixels[1];
+			result.z = pixels[2];
+			result.w = pixels[3];
+			_MM_TRANSPOSE4_PS(result.x, result.y, result.z, result.w);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					mFragments->Insert(index[lane] - lane, 1 << lane, result, z);
+				}
+			}
+		}
+		else if (mColor->GetElementSize() == 16)
+		{
+			float* target = (float*)mColor->GetData();
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					_mm_storeu_ps(target + (size_t)index[lane] * 4, pixels[lane]);
+				}
+			}
+		}
+		else
+		{
+			uint32_t bytes[4];
+			PackPixels(pixels, bytes);
+
+			uint32_t* target = (uint32_t*)mColor->GetData();
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					target[index[lane]] = bytes[lane];
+				}
+			}
+		}
+
+		mStatistics.pixels += LaneCount(mask);
+	}
+
+	void Rasterizer::BlendFragment(int x, int y, const float* attributes, float coverage)
+	{
+		if (x < (int)mScissor.x || y < (int)mScissor.y || x >= (int)(mScissor.x + mScissor.width) || y >= (int)(mScissor.y + mScissor.height))
+		{
+			return;
+		}
+
+		// Multisampled, blend weight turns into the number of samples covered (alpha to coverage)
+		if (mMultisample)
+		{
+			uint32_t sampleCount = mMultisample->GetSampleCount();
+			uint32_t covered = (uint32_t)(coverage * attributes[4] * sampleCount + 0.5f);
+			if (covered)
+			{
+				float depths[8];
+				std::fill(depths, depths + 8, attributes[0]);
+				uint32_t color = PackColor(float4(attributes[1], attributes[2], attributes[3], attributes[4]));
+				uint32_t passed = mMultisample->DepthTest((uint32_t)x, (uint32_t)y, (1u << covered) - 1, depths);
+				if (passed)
+				{
+					mMultisample->WriteColor((uint32_t)x, (uint32_t)y, passed, color);
+					mStatistics.pixels++;
+				}
+			}
+			return;
+		}
+
+		// Fringes overlap other geometry, test depth but do not write it
+		uint32_t index = (uint32_t)y * mWidth + (uint32_t)x;
+		if (mDepth && attributes[0] >= ((const float*)mDepth->GetData())[index])
+		{
+			return;
+		}
+
+		float alpha = coverage * attributes[4];
+		__m128 source = _mm_set_ps(attributes[4], attributes[3], attributes[2], attributes[1]);
+		__m128 weight = _mm_set1_ps(alpha);
+		if (mColor->GetElementSize() == 16)
+		{
+			float* color = (float*)mColor->GetData() + (size_t)index * 4;
+			__m128 destination = _mm_loadu_ps(color);
+			_mm_storeu_ps(color, _mm_add_ps(destination, _mm_mul_ps(_mm_sub_ps(source, destination), weight)));
+		}
+		else
+		{
+			uint32_t* color = (uint32_t*)mColor->GetData() + index;
+			__m128i unpacked = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)*color), _mm_setzero_si128()), _mm_setzero_si128());
+			__m128 destination = _mm_mul_ps(_mm_cvtepi32_ps(unpacked), _mm_set1_ps(1.0f / 255.0f));
+			__m128 blended = _mm_add_ps(destination, _mm_mul_ps(_mm_sub_ps(source, destination), weight));
+			blended = _mm_min_ps(_mm_max_ps(blended, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			__m128i packed = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(blended, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+			packed = _mm_packs_epi32(packed, packed);
+			*color = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+		}
+		mStatistics.pixels++;
+	}
+
+	void Rasterizer::DrawLineAntialiased(const float* a, const float* b, float ax, float ay, float bx, float by)
+	{
+		// Wu: step along major axis, split every step between the two pixels straddling the line
+		bool steep = fabsf(by - ay) > fabsf(bx - ax);
+		float major0 = steep ? ay : ax;
+		float major1 = steep ? by : bx;
+		float minor0 = steep ? ax : ay;
+		float minor1 = steep ? bx : by;
+		if (major0 == major1)
+		{
+			mStatistics.degenerate++;
+			return;
+		}
+
+		int first;
+		int last;
+		PixelRange(std::min(major0, major1), std::max(major0, major1), first, last);
+		int scissorMin = steep ? (int)mScissor.y : (int)mScissor.x;
+		int scissorMax = steep ? (int)(mScissor.y + mScissor.height) - 1 : (int)(mScissor.x + mScissor.width) - 1;
+		first = std::max(first, scissorMin);
+		last = std::min(last, scissorMax);
+
+		float dt = 1.0f / (major1 - major0);
+		float minorBase = floorf(minor0);
+		float minorFraction = minor0 - minorBase;
+		float attributes[Interpolants::Count];
+		for (int m = first; m <= last; m++)
+		{
+			float t = ((m + 0.5f) - major0) * dt;
+			for (int i = 0; i < Interpolants::Count; i++)
+			{
+				attributes[i] = a[i] + (b[i] - a[i]) * t;
+			}
+
+			// Minor coordinate relative to pixel centers, from the fractional part only like DrawLine
+			float minor = minorFraction + (minor1 - minor0) * t - 0.5f;
+			float base = floorf(minor);
+			float fraction = minor - base;
+			int pixel = (int)minorBase + (int)base;
+			if (steep)
+			{
+				BlendFragment(pixel, m, attributes, 1.0f - fraction);
+				BlendFragment(pixel + 1, m, attributes, fraction);
+			}
+			else
+			{
+				BlendFragment(m, pixel, attributes, 1.0f - fraction);
+				BlendFragment(m, pixel + 1, attributes, fraction);
+			}
+		}
+	}
+
+	void Rasterizer::DrawPoint(const Vertex& v)
+	{
+		mStatistics.points++;
+
+		float cx = v.position.x - mOriginX;
+		float cy = v.position.y - mOriginY;
+		float half = mPointSize * 0.5f;
+
+		int x0;
+		int x1;
+		int y0;
+		int y1;
+		PixelRange(cx - half, cx + half, x0, x1);
+		PixelRange(cy - half, cy + half, y0, y1);
+		x0 = std::max(x0, (int)mScissor.x);
+		y0 = std::max(y0, (int)mScissor.y);
+		x1 = std::min(x1, (int)(mScissor.x + mScissor.width) - 1);
+		y1 = std::min(y1, (int)(mScissor.y + mScissor.height) - 1);
+		if (x0 > x1 || y0 > y1)
+		{
+			mStatistics.culled++;
+			return;
+		}
+
+		// Flat attributes, one setup for all rows
+		float attributes[Interpolants::Count];
+		float zero[Interpolants::Count] = {};
+		GetAttributes(v, attributes);
+
+		Interpolants ip;
+		SetupSpan(attributes, zero, ip);
+		for (int y = y0; y <= y1; y++)
+		{
+			DrawSpan(ip, y, x0, x1, 0.0f);
+		}
+	}
+
+	void Rasterizer::ResetStatistics()
+	{
+		memset(&mStatistics, 0, sizeof(mStatistics));
+	}
+
+	void Rasterizer::PublishStatistics() const
+	{
+		PublishStatistics(mStatistics);
+	}
+
+	void Rasterizer::PublishStatistics(const Statistics& statistics)
+	{
+		Profiler& profiler = Profiler::Get();
+		profiler.Set("raster.submitted", (double)statistics.submitted);
+		profiler.Set("raster.degenerate", (double)statistics.degenerate);
+		profiler.Set("raster.culled", (double)statistics.culled);
+		profiler.Set("raster.small", (double)statistics.small);
+		profiler.Set("raster.large", (double)statistics.large);
+		profiler.Set("raster.lines", (double)statistics.lines);
+		profiler.Set("raster.points", (double)statistics.points);
+		profiler.Set("raster.pixels", (double)statistics.pixels);
+	}
+
+	void Rasterizer::DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+	{
+		DrawTriangle(v0, v1, v2, VertexColorShader());
+	}
+
+	void Rasterizer::DrawTriangles(const Vertex* vertices, const uint32_t* offsets, uint32_t count)
+	{
+		DrawTriangles(vertices, offsets, count, VertexColorShader());
+	}
+
+	void Rasterizer::DrawTriangleDepth(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+	{
+		DrawTriangle(v0, v1, v2, DepthOnlyShader());
+	}
+
+	void Rasterizer::DrawTrianglesDepth(const Vertex* vertices, const uint32_t* offsets, uint32_t count)
+	{
+		DrawTriangles(vertices, offsets, count, DepthOnlyShader());
+	}
+
+	bool Rasterizer::SetupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, Setup& s)
+	{
+		mStatistics.submitted++;
+
+		// Snap to fixed point, moving by whole pixels to target space keeps coverage exact
+		const Vertex* v[3] = { &v0, &v1, &v2 };
+		int64_t x[3];
+		int64_t y[3];
+		for (int i = 0; i < 3; i++)
+		{
+			x[i] = Snap(v[i]->position.x) - (int64_t)mOriginX * SubpixelScale;
+			y[i] = Snap(v[i]->position.y) - (int64_t)mOriginY * SubpixelScale;
+		}
+
+		// Pixel centers (px * 16 + 8) inside bounding box, none left means no sample is covered and the triangle is
+		// culled before area and edge setup
+		int64_t minXf = std::min(x[0], std::min(x[1], x[2]));
+		int64_t minYf = std::min(y[0], std::min(y[1], y[2]));
+		int64_t maxXf = std::max(x[0], std::max(x[1], x[2]));
+		int64_t maxYf = std::max(y[0], std::max(y[1], y[2]));
+
+		// Multisampled pixels are taken when any of their samples can be inside
+		const int64_t half = SubpixelScale / 2;
+		s.minX = (int)std::max((minXf - half - mSampleReach + SubpixelScale - 1) >> SubpixelBits, (int64_t)mScissor.x);
+		s.minY = (int)std::max((minYf - half - mSampleReach + SubpixelScale - 1) >> SubpixelBits, (int64_t)mScissor.y);
+		s.maxX = (int)std::min((maxXf - half + mSampleReach) >> SubpixelBits, (int64_t)(mScissor.x + mScissor.width) - 1);
+		s.maxY = (int)std::min((maxYf - half + mSampleReach) >> SubpixelBits, (int64_t)(mScissor.y + mScissor.height) - 1);
+		if (s.minX > s.maxX || s.minY > s.maxY)
+		{
+			mStatistics.culled++;
+			return false;
+		}
+
+		// Degenerate after snapping, both windings are drawn so make area positive
+		int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+		if (area == 0)
+		{
+			mStatistics.degenerate++;
+			return false;
+		}
+		if (area < 0)
+		{
+			std::swap(v[1], v[2]);
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			area = -area;
+		}
+
+		// Edge i is opposite to vertex i, so w[i] / area is barycentric weight of vertex i
+		int64_t px = (int64_t)s.minX * SubpixelScale + half;
+		int64_t py = (int64_t)s.minY * SubpixelScale + half;
+		for (int i = 0; i < 3; i++)
+		{
+			int a = (i + 1) % 3;
+			int b = (i + 2) % 3;
+			int64_t dx = x[b] - x[a];
+			int64_t dy = y[b] - y[a];
+			bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+
+			s.w[i] = dx * (py - y[a]) - dy * (px - x[a]) - (topLeft ? 0 : 1);
+			s.stepX[i] = -dy * SubpixelScale;
+			s.stepY[i] = dx * SubpixelScale;
+		}
+
+		s.v[0] = v[0];
+		s.v[1] = v[1];
+		s.v[2] = v[2];
+		s.invArea = 1.0f / (float)area;
+
+		// Unclipped extent decides (less than 4 pixels holds at most 4 centers), it also bounds edge values so
+		// the small path can stay in 32 bits
+		int64_t reach = 2 * mSampleReach;
+		s.small = mSmallTrianglePath && maxXf - minXf + reach < SmallSize * SubpixelScale && maxYf - minYf + reach < SmallSize * SubpixelScale;
+		return true;
+	}
+
+	int Rasterizer::SetupTriangles(const Vertex* const* v, int valid, Setup* setups, int& drawn)
+	{
+		drawn = 0;
+		if (!mSmallTrianglePath || mMultisample)
+		{
+			return valid;
+		}
+
+		// Snapped like Snap, x and y of vertex i of the four triangles transposed into lanes
+		__m128 scale = _mm_set1_ps((float)SubpixelScale);
+		__m128i originX = _mm_set1_epi32(mOriginX * SubpixelScale);
+		__m128i originY = _mm_set1_epi32(mOriginY * SubpixelScale);
+		__m128i x[3];
+		__m128i y[3];
+		for (int i = 0; i < 3; i++)
+		{
+			__m128 xy01 = _mm_unpacklo_ps(_mm_loadu_ps(&v[i]->position.x), _mm_loadu_ps(&v[3 + i]->position.x));
+			__m128 xy23 = _mm_unpacklo_ps(_mm_loadu_ps(&v[6 + i]->position.x), _mm_loadu_ps(&v[9 + i]->position.x));
+			x[i] = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_movelh_ps(xy01, xy23), scale)), originX);
+			y[i] = _mm_sub_epi32(_mm_cvtps_epi32(_mm_mul_ps(_mm_movehl_ps(xy23, xy01), scale)), originY);
+		}
+
+		__m128i minXf = Min(x[0], Min(x[1], x[2]));
+		__m128i minYf = Min(y[0], Min(y[1], y[2]));
+		__m128i maxXf = Max(x[0], Max(x[1], x[2]));
+		__m128i maxYf = Max(y[0], Max(y[1], y[2]));
+
+		// Only small triangles are taken, coordinates far enough to wrap in 32 bits are left to SetupTriangle
+		__m128i limit = _mm_set1_epi32(1 << 30);
+		__m128i negativeLimit = _mm_set1_epi32(-(1 << 30));
+		__m128i extent = _mm_set1_epi32(SmallSize * SubpixelScale);
+		__m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(minXf, negativeLimit), _mm_cmpgt_epi32(minYf, negativeLimit)),
+			_mm_and_si128(_mm_cmplt_epi32(maxXf, limit), _mm_cmplt_epi32(maxYf, limit)));
+		__m128i small = _mm_and_si128(_mm_cmplt_epi32(_mm_sub_epi32(maxXf, minXf), extent), _mm_cmplt_epi32(_mm_sub_epi32(maxYf, minYf), extent));
+		int smallMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(inside, small))) & valid;
+		if (!smallMask)
+		{
+			return valid;
+		}
+
+		// Pixel centers inside bounding box like in SetupTriangle, culled before anything else
+		const int half = SubpixelScale / 2;
+		__m128i minX = Max(_mm_srai_epi32(_mm_add_epi32(minXf, _mm_set1_epi32(SubpixelScale - 1 - half)), SubpixelBits), _mm_set1_epi32((int)mScissor.x));
+		__m128i minY = Max(_mm_srai_epi32(_mm_add_epi32(minYf, _mm_set1_epi32(SubpixelScale - 1 - half)), SubpixelBits), _mm_set1_epi32((int)mScissor.y));
+		__m128i maxX = Min(_mm_srai_epi32(_mm_sub_epi32(maxXf, _mm_set1_epi32(half)), SubpixelBits), _mm_set1_epi32((int)(mScissor.x + mScissor.width) - 1));
+		__m128i maxY = Min(_mm_srai_epi32(_mm_sub_epi32(maxYf, _mm_set1_epi32(half)), SubpixelBits), _mm_set1_epi32((int)(mScissor.y + mScissor.height) - 1));
+		int emptyMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_cmpgt_epi32(minX, maxX), _mm_cmpgt_epi32(minY, maxY)))) & smallMask;
+
+		// Coordinates differ by less than 4 pixels, products stay exact in float
+		auto difference = [](__m128i a, __m128i b)
+		{
+			return _mm_cvtepi32_ps(_mm_sub_epi32(a, b));
+		};
+		__m128 zero = _mm_setzero_ps();
+		__m128 area = _mm_sub_ps(_mm_mul_ps(difference(x[1], x[0]), difference(y[2], y[0])), _mm_mul_ps(difference(y[1], y[0]), difference(x[2], x[0])));
+		int degenerateMask = _mm_movemask_ps(_mm_cmpeq_ps(area, zero)) & smallMask & ~emptyMask;
+
+		__m128 negative = _mm_cmplt_ps(area, zero);
+		int flipMask = _mm_movemask_ps(negative);
+		__m128i flip = _mm_castps_si128(negative);
+		__m128i x1 = Select(flip, x[2], x[1]);
+		__m128i y1 = Select(flip, y[2], y[1]);
+		x[2] = Select(flip, x[1], x[2]);
+		y[2] = Select(flip, y[1], y[2]);
+		x[1] = x1;
+		y[1] = y1;
+		area = Select(negative, _mm_sub_ps(zero, area), area);
+
+		// Edge functions at the first pixel center, same fill rule bias as SetupTriangle
+		__m128i zeroInt = _mm_setzero_si128();
+		__m128i px = _mm_add_epi32(_mm_slli_epi32(minX, SubpixelBits), _mm_set1_epi32(half));
+		__m128i py = _mm_add_epi32(_mm_slli_epi32(minY, SubpixelBits), _mm_set1_epi32(half));
+		__m128i w[3];
+		__m128i stepX[3];
+		__m128i stepY[3];
+		for (int i = 0; i < 3; i++)
+		{
+			int a = (i + 1) % 3;
+			int b = (i + 2) % 3;
+			__m128i dx = _mm_sub_epi32(x[b], x[a]);
+			__m128i dy = _mm_sub_epi32(y[b], y[a]);
+			__m128i topLeft = _mm_or_si128(_mm_cmplt_epi32(dy, zeroInt), _mm_and_si128(_mm_cmpeq_epi32(dy, zeroInt), _mm_cmpgt_epi32(dx, zeroInt)));
+			__m128 edge = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(dx), difference(py, y[a])), _mm_mul_ps(_mm_cvtepi32_ps(dy), difference(px, x[a])));
+			w[i] = _mm_sub_epi32(_mm_cvttps_epi32(edge), _mm_andnot_si128(topLeft, _mm_set1_epi32(1)));
+			stepX[i] = _mm_slli_epi32(_mm_sub_epi32(zeroInt, dy), SubpixelBits);
+			stepY[i] = _mm_slli_epi32(dx, SubpixelBits);
+		}
+
+		// A bounding box holding a single pixel center is covered only if no edge is negative there
+		__m128i single = _mm_and_si128(_mm_cmpeq_epi32(minX, maxX), _mm_cmpeq_epi32(minY, maxY));
+		__m128i missed = _mm_and_si128(single, _mm_cmplt_epi32(_mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]), zeroInt));
+		int missedMask = _mm_movemask_ps(_mm_castsi128_ps(missed)) & smallMask & ~emptyMask & ~degenerateMask;
+
+		drawn = smallMask & ~(emptyMask | degenerateMask | missedMask);
+		mStatistics.submitted += LaneCount(smallMask);
+		mStatistics.culled += LaneCount(emptyMask | missedMask);
+		mStatistics.degenerate += LaneCount(degenerateMask);
+		if (!drawn)
+		{
+			return valid & ~smallMask;
+		}
+
+		int32_t bounds[4][4];
+		int32_t edges[3][3][4];
+		float invArea[4];
+		_mm_storeu_si128((__m128i*)bounds[0], minX);
+		_mm_storeu_si128((__m128i*)bounds[1], minY);
+		_mm_storeu_si128((__m128i*)bounds[2], maxX);
+		_mm_storeu_si128((__m128i*)bounds[3], maxY);
+		for (int i = 0; i < 3; i++)
+		{
+			_mm_storeu_si128((__m128i*)edges[0][i], w[i]);
+			_mm_storeu_si128((__m128i*)edges[1][i], stepX[i]);
+			_mm_storeu_si128((__m128i*)edges[2][i], stepY[i]);
+		}
+		_mm_storeu_ps(invArea, _mm_div_ps(_mm_set1_ps(1.0f), area));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if (!(drawn & (1 << lane)))
+			{
+				continue;
+			}
+
+			Setup& s = setups[lane];
+			bool flipped = (flipMask & (1 << lane)) != 0;
+			s.v[0] = v[lane * 3];
+			s.v[1] = v[lane * 3 + (flipped ? 2 : 1)];
+			s.v[2] = v[lane * 3 + (flipped ? 1 : 2)];
+			s.minX = bounds[0][lane];
+			s.minY = bounds[1][lane];
+			s.maxX = bounds[2][lane];
+			s.maxY = bounds[3][lane];
+			for (int i = 0; i < 3; i++)
+			{
+				s.w[i] = edges[0][i][lane];
+				s.stepX[i] = edges[1][i][lane];
+				s.stepY[i] = edges[2][i][lane];
+			}
+			s.invArea = invArea[lane];
+			s.small = true;
+		}
+
+		return valid & ~smallMask;
+	}
+
+	void Rasterizer::SetupInterpolants(const Setup& s, Interpolants& ip, int count) const
+	{
+		// Depth, then all 4 components of color and texcoord, depth-only passes stop after the first
+		float z0 = s.v[0]->position.z;
+		ip.base[0] = _mm_set1_ps(z0);
+		ip.d1[0] = _mm_set1_ps(s.v[1]->position.z - z0);
+		ip.d2[0] = _mm_set1_ps(s.v[2]->position.z - z0);
+		if (count == 1)
+		{
+			return;
+		}
+
+		// Differences of color and texcoord are taken four components at once
+		const float4* attributes[2][3] =
+		{
+			{ &s.v[0]->color, &s.v[1]->color, &s.v[2]->color },
+			{ &s.v[0]->texcoord, &s.v[1]->texcoord, &s.v[2]->texcoord }
+		};
+		for (int i = 0; i < 2; i++)
+		{
+			__m128 a0 = _mm_loadu_ps(&attributes[i][0]->x);
+			__m128 a1 = _mm_loadu_ps(&attributes[i][1]->x);
+			__m128 a2 = _mm_loadu_ps(&attributes[i][2]->x);
+			Broadcast(a0, ip.base + 1 + i * 4);
+			Broadcast(_mm_sub_ps(a1, a0), ip.d1 + 1 + i * 4);
+			Broadcast(_mm_sub_ps(a2, a0), ip.d2 + 1 + i * 4);
+		}
+	}
+
+	void Rasterizer::SetupSamples(const Setup& s, SamplePlanes& planes) const
+	{
+		// Sample positions are multiples of 1/16 pixel, edge offsets are exact in 28.4 fixed point
+		const float* positions = MultisampleBuffer::GetSamplePositions(mMultisample->GetSampleCount());
+		float z0 = s.v[0]->position.z;
+		float d1 = s.v[1]->position.z - z0;
+		float d2 = s.v[2]->position.z - z0;
+		float depthX = ((float)s.stepX[1] * d1 + (float)s.stepX[2] * d2) * s.invArea;
+		float depthY = ((float)s.stepY[1] * d1 + (float)s.stepY[2] * d2) * s.invArea;
+		std::fill(planes.depth, planes.depth + 8, 0.0f);
+		for (uint32_t i = 0; i < mMultisample->GetSampleCount(); i++)
+		{
+			int64_t x = (int64_t)(positions[i * 2] * SubpixelScale);
+			int64_t y = (int64_t)(positions[i * 2 + 1] * SubpixelScale);
+			for (int e = 0; e < 3; e++)
+			{
+				planes.edge[e][i] = (x * s.stepX[e] + y * s.stepY[e]) / SubpixelScale;
+				planes.low[e] = i ? std::min(planes.low[e], planes.edge[e][i]) : planes.edge[e][i];
+				planes.high[e] = i ? std::max(planes.high[e], planes.edge[e][i]) : planes.edge[e][i];
+			}
+			planes.depth[i] = positions[i * 2] * depthX + positions[i * 2 + 1] * depthY;
+		}
+
+		for (int e = 0; e < 3; e++)
+		{
+			planes.narrowLow[e] = _mm_set1_epi32((int32_t)planes.low[e]);
+			planes.narrowHigh[e] = _mm_set1_epi32((int32_t)planes.high[e]);
+		}
+	}
+}
\ No newline at end of file
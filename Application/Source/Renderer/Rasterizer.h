@@ -0,0 +1,287 @@
+#pragma once
+
+#include "Buffer.h"
+#include "FragmentBuffer.h"
+#include "MultisampleBuffer.h"
+#include "Shader.h"
+#include "TileGrid.h"
+#include "Vertex.h"
+
+namespace Renderer
+{
+	/**
+	 * @class Rasterizer
+	 * @brief Triangle rasterizer writing RGBA8 or float4 color and float depth.
+	 *
+	 * Vertices are snapped to 28.4 fixed point, coverage is tested at pixel centers with top-left fill rule.
+	 * Triangles whose bounding box contains no pixel center are culled before edge setup, degenerate ones are
+	 * rejected right after. Triangles with bounding box up to 4x4 pixels take a dedicated SIMD path, drawn as a
+	 * batch they are also set up four at once and the ones missing their only pixel center are culled there.
+	 * Everything else is traversed in 8x8 blocks with trivial accept / reject. Covered pixels are depth tested
+	 * and shaded in packets of 4 horizontally adjacent pixels.
+	 *
+	 * Lines and points are native primitives. Lines are stepped along the major axis (DDA) four pixels per
+	 * packet with per-lane addresses, so steep and diagonal runs fill whole packets. Square points are filled as
+	 * horizontal spans. Antialiased lines
+	 * blend two pixels per step weighted by distance (Wu), depth tested without depth write.
+	 *
+	 * With a FragmentBuffer set, shaded fragments are depth tested against opaque depth without writing it and
+	 * stored for order-independent transparency instead of written to color.
+	 *
+	 * With a MultisampleBuffer set, triangle edges and depth are evaluated at its sample positions instead of
+	 * the pixel center, color is shaded once per pixel with any sample covered and written through
+	 * MultisampleBuffer::Write. Pixels inside all edges at every sample are tested and written as whole packets.
+	 * Line and point pixels cover all their samples, antialiased line fringes as many samples as their blend
+	 * weight (alpha to coverage). Color and depth targets are not used then.
+	 */
+	class Rasterizer
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t submitted;
+			uint64_t degenerate;
+			uint64_t culled;
+			uint64_t small;
+			uint64_t large;
+			uint64_t lines;
+			uint64_t points;
+			uint64_t pixels;
+		};
+
+		static const int SubpixelBits = 4;
+		static const int SubpixelScale = 1 << SubpixelBits;
+		static const int BlockSize = 8;
+		static const int SmallSize = 4;
+
+	protected:
+		struct Setup
+		{
+			/** @brief Vertices in positive winding order. */
+			const Vertex* v[3];
+
+			/** @brief Pixel range whose centers lie in triangle bounding box (inclusive, scissored). */
+			int minX;
+			int minY;
+			int maxX;
+			int maxY;
+
+			/** @brief Edge functions at center of pixel (minX, minY), fill rule bias applied. */
+			int64_t w[3];
+			int64_t stepX[3];
+			int64_t stepY[3];
+
+			float invArea;
+			bool small;
+		};
+
+		/**
+		 * @brief Per triangle edge function and depth offsets of every sample from the pixel center.
+		 */
+		struct SamplePlanes
+		{
+			int64_t edge[3][8];
+			float depth[8];
+			/** @brief Smallest and largest edge offset over the samples, decide inner and outer pixels at once. */
+			int64_t low[3];
+			int64_t high[3];
+			/** @brief low and high broadcast for triangles whose edge functions fit 32 bits. */
+			__m128i narrowLow[3];
+			__m128i narrowHigh[3];
+		};
+
+		/**
+		 * @brief Per triangle attribute planes broadcast to SSE registers (depth, color, texcoord).
+		 */
+		struct Interpolants
+		{
+			static const int Count = 9;
+
+			__m128 base[Count];
+			__m128 d1[Count];
+			__m128 d2[Count];
+		};
+
+		Buffer* mColor;
+		Buffer* mDepth;
+		uint32_t mWidth;
+		uint32_t mHeight;
+		Rect mScissor;
+		int mOriginX;
+		int mOriginY;
+		bool mSmallTrianglePath;
+		bool mLineAntialiasing;
+		float mPointSize;
+		FragmentBuffer* mFragments;
+		MultisampleBuffer* mMultisample;
+		/** @brief Farthest sample from the pixel center along x or y, in subpixels (0 without multisampling). */
+		int mSampleReach;
+
+		Statistics mStatistics;
+
+		bool SetupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, Setup& setup);
+
+		/**
+		 * @brief Sets up four triangles (vertices[lane * 3 + i]) at once, small ones end up in setups or culled.
+		 * @param valid Mask of lanes holding a triangle.
+		 * @param drawn Receives mask of lanes with a small setup ready for DrawSmall.
+		 * @return Mask of valid lanes left for SetupTriangle.
+		 */
+		int SetupTriangles(const Vertex* const* vertices, int valid, Setup* setups, int& drawn);
+		void SetupInterpolants(const Setup& setup, Interpolants& interpolants, int count) const;
+		void SetupSamples(const Setup& setup, SamplePlanes& planes) const;
+
+		void SetupSpan(const float* start, const float* step, Interpolants& interpolants) const;
+		void DrawSpan(const Interpolants& interpolants, int y, int x0, int x1, float origin);
+		void ShadeScattered(const uint32_t* index, int mask, __m128 offset, float depth, float depthStep, __m128 color,
+			__m128 colorStep);
+		void BlendFragment(int x, int y, const float* attributes, float coverage);
+		void DrawLineAntialiased(const float* a, const float* b, float ax, float ay, float bx, float by);
+
+		template<typename Shader>
+		void DrawSmall(const Setup& setup, const Shader& shader);
+
+		template<typename Shader>
+		void DrawLarge(const Setup& setup, const Shader& shader);
+
+		/**
+		 * @brief Number of lanes set in a packet mask.
+		 */
+		static int LaneCount(int mask) { return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1); }
+
+		/**
+		 * @brief Clamps packet color to [0, 1] and packs it to one RGBA8 pixel per lane.
+		 */
+		static __m128i PackPacket(const PacketFloat4& color);
+
+		template<typename Shader>
+		void ShadePacket(const Setup& setup, const Interpolants& interpolants, int x, int y, int mask, __m128 w1, __m128 w2, const Shader& shader);
+
+		/**
+		 * @brief Covered samples of 4 pixels from 32 bit edge functions at their centers, pixels inside every edge
+		 * at every sample skip the per sample tests.
+		 * @return Mask of lanes with any sample covered.
+		 */
+		int CoverSamples(const SamplePlanes& planes, const __m128i* w, int valid, uint32_t* coverage) const;
+
+		/**
+		 * @brief CoverSamples for edge functions past 32 bits, [edge][lane].
+		 */
+		int CoverSamples(const SamplePlanes& planes, const int64_t (*w)[4], int valid, uint32_t* coverage) const;
+
+		/**
+		 * @brief Multisampled ShadePacket, depth tests the covered samples and shades pixels with any sample passed.
+		 * @param coverage Covered samples per lane from CoverSamples.
+		 */
+		template<typename Shader>
+		void ShadeMultisample(const Setup& setup, const Interpolants& interpolants, const SamplePlanes& planes, int x, int y,
+			uint32_t* coverage, __m128 w1, __m128 w2, const Shader& shader);
+
+	public:
+		/**
+		 * @param color RGBA8 (4 byte elements) or HDR float4 (16 byte elements) target of width * height elements,
+		 * may be null when only DrawTriangleDepth, DrawTrianglesDepth or a MultisampleBuffer is used.
+		 * @param depth Float depth target of width * height elements, may be null to disable depth test.
+		 */
+		Rasterizer(Buffer* color, Buffer* depth, uint32_t width, uint32_t height);
+
+		/**
+		 * @brief Restricts rasterization to rectangle (defaults to whole target).
+		 */
+		void SetScissor(const Rect& scissor);
+
+		/**
+		 * @brief Sets screen position of target pixel (0, 0), used to render a tile into a tile sized target.
+		 */
+		void SetOrigin(int x, int y);
+
+		/**
+		 * @brief Enables specialized path for triangles covering at most 4x4 pixels (enabled by default).
+		 */
+		void SetSmallTrianglePath(bool enabled) { mSmallTrianglePath = enabled; }
+
+		/**
+		 * @brief Enables antialiased lines, coverage is blended into color with alpha (disabled by default).
+		 */
+		void SetLineAntialiasing(bool enabled) { mLineAntialiasing = enabled; }
+
+		/**
+		 * @brief Sets point width and height in pixels (default 1).
+		 */
+		void SetPointSize(float size) { mPointSize = size; }
+
+		/**
+		 * @brief Redirects shaded fragments into k-buffer of target size, null (default) writes color directly.
+		 */
+		void SetFragmentBuffer(FragmentBuffer* fragments) { mFragments = fragments; }
+
+		/**
+		 * @brief Rasterizes triangles into multisampled target of target size, null (default) disables MSAA.
+		 */
+		void SetMultisampleBuffer(MultisampleBuffer* target);
+
+		/**
+		 * @brief Draws triangle with interpolated vertex color.
+		 */
+		void DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+		/**
+		 * @brief Draws count triangles like DrawTriangle, in order, with setup done for four small triangles at once.
+		 * @param offsets Index of the first vertex of every triangle, nullptr for consecutive vertex triples.
+		 */
+		void DrawTriangles(const Vertex* vertices, const uint32_t* offsets, uint32_t count);
+
+		/**
+		 * @brief Draws line with interpolated vertex color, pixel centers in [start, end) along the major axis so
+		 * connected lines do not overlap.
+		 */
+		void DrawLine(const Vertex& v0, const Vertex& v1);
+
+		/**
+		 * @brief Draws count lines like DrawLine, in order, with setup done for four lines at once.
+		 * @param offsets Index of the first vertex of every line, nullptr for consecutive vertex pairs.
+		 */
+		void DrawLines(const Vertex* vertices, const uint32_t* offsets, uint32_t count);
+
+		/**
+		 * @brief Draws square point of SetPointSize pixels centered at vertex position with its color and depth.
+		 */
+		void DrawPoint(const Vertex& v);
+
+		/**
+		 * @brief Depth-only kernel, no attribute setup or shading, only the depth target is written.
+		 */
+		void DrawTriangleDepth(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+		/**
+		 * @brief Draws count triangles like DrawTriangleDepth, batched like DrawTriangles.
+		 * @param offsets Index of the first vertex of every triangle, nullptr for consecutive vertex triples.
+		 */
+		void DrawTrianglesDepth(const Vertex* vertices, const uint32_t* offsets, uint32_t count);
+
+		/**
+		 * @brief Draws triangle with pixel shader compiled into the raster loop, see Shader.h.
+		 */
+		template<typename Shader>
+		void DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Shader& shader);
+
+		/**
+		 * @brief Batched DrawTriangle with pixel shader, see DrawTriangles above.
+		 */
+		template<typename Shader>
+		void DrawTriangles(const Vertex* vertices, const uint32_t* offsets, uint32_t count, const Shader& shader);
+
+		/**
+		 * @brief Runs vertex shader on triangle list of user vertices and draws the result with pixel shader.
+		 */
+		template<typename Input, typename VertexShader, typename PixelShader>
+		void DrawTriangles(const Input* vertices, size_t count, const VertexShader& vertexShader, const PixelShader& pixelShader);
+
+		const Statistics& GetStatistics() const { return mStatistics; }
+		void ResetStatistics();
+		void PublishStatistics() const;
+		static void PublishStatistics(const Statistics& statistics);
+	};
+}
+
+#include "Rasterizer.inl"
\ No newline at end of file
@@ -0,0 +1,570 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Renderer
+{
+	template<typename Shader>
+	void Rasterizer::DrawTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Shader& shader)
+	{
+		Setup s;
+		if (!SetupTriangle(v0, v1, v2, s))
+		{
+			return;
+		}
+
+		if (s.small)
+		{
+			DrawSmall(s, shader);
+		}
+		else
+		{
+			DrawLarge(s, shader);
+		}
+	}
+
+	template<typename Shader>
+	void Rasterizer::DrawTriangles(const Vertex* vertices, const uint32_t* offsets, uint32_t count, const Shader& shader)
+	{
+		for (uint32_t first = 0; first < count; first += 4)
+		{
+			// A short last group repeats its last triangle in the unused lanes
+			const Vertex* v[12];
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				uint32_t t = std::min(first + lane, count - 1);
+				const Vertex* triangle = vertices + (offsets ? offsets[t] : t * 3);
+				v[lane * 3] = triangle;
+				v[lane * 3 + 1] = triangle + 1;
+				v[lane * 3 + 2] = triangle + 2;
+			}
+
+			int valid = (1 << std::min(count - first, 4u)) - 1;
+			Setup setups[4];
+			int drawn;
+			int scalar = SetupTriangles(v, valid, setups, drawn);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (drawn & (1 << lane))
+				{
+					DrawSmall(setups[lane], shader);
+				}
+				else if (scalar & (1 << lane))
+				{
+					DrawTriangle(*v[lane * 3], *v[lane * 3 + 1], *v[lane * 3 + 2], shader);
+				}
+			}
+		}
+	}
+
+	template<typename Input, typename VertexShader, typename PixelShader>
+	void Rasterizer::DrawTriangles(const Input* vertices, size_t count, const VertexShader& vertexShader, const PixelShader& pixelShader)
+	{
+		for (size_t i = 0; i + 2 < count; i += 3)
+		{
+			Vertex v0 = vertexShader(vertices[i]);
+			Vertex v1 = vertexShader(vertices[i + 1]);
+			Vertex v2 = vertexShader(vertices[i + 2]);
+			DrawTriangle(v0, v1, v2, pixelShader);
+		}
+	}
+
+	template<typename Shader>
+	void Rasterizer::DrawSmall(const Setup& s, const Shader& shader)
+	{
+		// Multisampled, every row of the bounding box is one packet and coverage is decided per sample
+		if (mMultisample)
+		{
+			mStatistics.small++;
+			Interpolants interpolants;
+			SetupInterpolants(s, interpolants, ShaderTraits<Shader>::DepthOnly ? 1 : Interpolants::Count);
+			SamplePlanes planes;
+			SetupSamples(s, planes);
+
+			// Edge functions of small triangles fit 32 bits also at the samples, bounding box includes their reach
+			int valid = (1 << (s.maxX - s.minX + 1)) - 1;
+			__m128i w[3];
+			for (int i = 0; i < 3; i++)
+			{
+				int32_t step = (int32_t)s.stepX[i];
+				w[i] = _mm_add_epi32(_mm_set1_epi32((int32_t)s.w[i]), _mm_set_epi32(3 * step, 2 * step, step, 0));
+			}
+			for (int y = s.minY; y <= s.maxY; y++)
+			{
+				uint32_t coverage[4];
+				if (CoverSamples(planes, w, valid, coverage))
+				{
+					ShadeMultisample(s, interpolants, planes, s.minX, y, coverage, _mm_cvtepi32_ps(w[1]), _mm_cvtepi32_ps(w[2]), shader);
+				}
+				for (int i = 0; i < 3; i++)
+				{
+					w[i] = _mm_add_epi32(w[i], _mm_set1_epi32((int32_t)s.stepY[i]));
+				}
+			}
+			return;
+		}
+
+		// At most 4x4 pixels, one SSE register holds edge values of a whole row
+		__m128i row[3];
+		__m128i stepY[3];
+		for (int i = 0; i < 3; i++)
+		{
+			int32_t w = (int32_t)s.w[i];
+			int32_t step = (int32_t)s.stepX[i];
+			row[i] = _mm_set_epi32(w + 3 * step, w + 2 * step, w + step, w);
+			stepY[i] = _mm_set1_epi32((int32_t)s.stepY[i]);
+		}
+
+		// Coverage of all rows first, most micro triangles end up covering nothing
+		int columnMask = (1 << (s.maxX - s.minX + 1)) - 1;
+		int rows = s.maxY - s.minY + 1;
+		int covered[SmallSize];
+		int any = 0;
+		for (int y = 0; y < rows; y++)
+		{
+			// Covered where no edge function is negative
+			__m128i sign = _mm_or_si128(_mm_or_si128(row[0], row[1]), row[2]);
+			covered[y] = ~_mm_movemask_ps(_mm_castsi128_ps(sign)) & columnMask;
+			any |= covered[y];
+
+			for (int i = 0; i < 3; i++)
+			{
+				row[i] = _mm_add_epi32(row[i], stepY[i]);
+			}
+		}
+
+		if (!any)
+		{
+			mStatistics.culled++;
+			return;
+		}
+		mStatistics.small++;
+
+		// Every covered row is exactly one packet
+		Interpolants interpolants;
+		SetupInterpolants(s, interpolants, ShaderTraits<Shader>::DepthOnly ? 1 : Interpolants::Count);
+
+		__m128i w1 = _mm_set_epi32((int32_t)(s.w[1] + 3 * s.stepX[1]), (int32_t)(s.w[1] + 2 * s.stepX[1]), (int32_t)(s.w[1] + s.stepX[1]), (int32_t)s.w[1]);
+		__m128i w2 = _mm_set_epi32((int32_t)(s.w[2] + 3 * s.stepX[2]), (int32_t)(s.w[2] + 2 * s.stepX[2]), (int32_t)(s.w[2] + s.stepX[2]), (int32_t)s.w[2]);
+		for (int y = 0; y < rows; y++)
+		{
+			if (covered[y])
+			{
+				ShadePacket(s, interpolants, s.minX, s.minY + y, covered[y], _mm_cvtepi32_ps(w1), _mm_cvtepi32_ps(w2), shader);
+			}
+			w1 = _mm_add_epi32(w1, stepY[1]);
+			w2 = _mm_add_epi32(w2, stepY[2]);
+		}
+	}
+
+	template<typename Shader>
+	void Rasterizer::DrawLarge(const Setup& s, const Shader& shader)
+	{
+		mStatistics.large++;
+
+		Interpolants interpolants;
+		SetupInterpolants(s, interpolants, ShaderTraits<Shader>::DepthOnly ? 1 : Interpolants::Count);
+
+		int blockMinX = s.minX & ~(BlockSize - 1);
+		int blockMinY = s.minY & ~(BlockSize - 1);
+
+		// Multisampled blocks also cover samples up to mSampleReach past their outer pixel centers, rejection
+		// leaves that much slack (zero without multisampling)
+		SamplePlanes planes;
+		int64_t slack[3];
+		for (int i = 0; i < 3; i++)
+		{
+			slack[i] = mSampleReach * (std::abs(s.stepX[i]) + std::abs(s.stepY[i])) / SubpixelScale;
+		}
+		if (mMultisample)
+		{
+			SetupSamples(s, planes);
+		}
+
+		// Edge functions are linear, if they fit 32 bits at the bounding box corners (packets reach 3 pixels past
+		// maxX, samples the slack past the center) they fit everywhere inside and a packet is covered with SSE
+		// integer math
+		bool narrow = true;
+		for (int i = 0; i < 3; i++)
+		{
+			int64_t dx = (s.maxX + 3 - s.minX) * s.stepX[i];
+			int64_t dy = (s.maxY - s.minY) * s.stepY[i];
+			int64_t corners[4] = { s.w[i], s.w[i] + dx, s.w[i] + dy, s.w[i] + dx + dy };
+			for (int64_t corner : corners)
+			{
+				narrow &= corner - slack[i] > INT32_MIN && corner + slack[i] < INT32_MAX;
+			}
+		}
+
+		__m128i laneStep[3];
+		for (int i = 0; i < 3; i++)
+		{
+			int32_t step = (int32_t)s.stepX[i];
+			laneStep[i] = _mm_set_epi32(3 * step, 2 * step, step, 0);
+		}
+
+		for (int by = blockMinY; by <= s.maxY; by += BlockSize)
+		{
+			for (int bx = blockMinX; bx <= s.maxX; bx += BlockSize)
+			{
+				int x0 = std::max(bx, s.minX);
+				int y0 = std::max(by, s.minY);
+				int x1 = std::min(bx + BlockSize - 1, s.maxX);
+				int y1 = std::min(by + BlockSize - 1, s.maxY);
+
+				// Edge functions are linear, testing block corners is enough for trivial reject / accept
+				bool reject = false;
+				bool accept = true;
+				int64_t origin[3];
+				for (int i = 0; i < 3; i++)
+				{
+					origin[i] = s.w[i] + (x0 - s.minX) * s.stepX[i] + (y0 - s.minY) * s.stepY[i];
+					int64_t dx = (x1 - x0) * s.stepX[i];
+					int64_t dy = (y1 - y0) * s.stepY[i];
+					int64_t c00 = origin[i];
+					int64_t c10 = origin[i] + dx;
+					int64_t c01 = origin[i] + dy;
+					int64_t c11 = origin[i] + dx + dy;
+					if (c00 < -slack[i] && c10 < -slack[i] && c01 < -slack[i] && c11 < -slack[i])
+					{
+						reject = true;
+						break;
+					}
+					if (c00 < 0 || c10 < 0 || c01 < 0 || c11 < 0)
+					{
+						accept = false;
+					}
+				}
+
+				if (reject)
+				{
+					continue;
+				}
+
+				for (int y = y0; y <= y1; y++)
+				{
+					for (int x = x0; x <= x1; x += 4)
+					{
+						int columns = std::min(x1 - x + 1, 4);
+						int valid = (1 << columns) - 1;
+
+						if (narrow)
+						{
+							__m128i w[3];
+							for (int i = 0; i < 3; i++)
+							{
+								w[i] = _mm_add_epi32(_mm_set1_epi32((int32_t)(origin[i] + (x - x0) * s.stepX[i])), laneStep[i]);
+							}
+
+							if (mMultisample)
+							{
+								uint32_t coverage[4];
+								if (CoverSamples(planes, w, valid, coverage))
+								{
+									ShadeMultisample(s, interpolants, planes, x, y, coverage, _mm_cvtepi32_ps(w[1]), _mm_cvtepi32_ps(w[2]), shader);
+								}
+								continue;
+							}
+
+							int mask = valid;
+							if (!accept)
+							{
+								__m128i sign = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+								mask &= ~_mm_movemask_ps(_mm_castsi128_ps(sign));
+							}
+
+							if (mask)
+							{
+								ShadePacket(s, interpolants, x, y, mask, _mm_cvtepi32_ps(w[1]), _mm_cvtepi32_ps(w[2]), shader);
+							}
+							continue;
+						}
+
+						int64_t w[3][4];
+						int mask = 0;
+						for (int lane = 0; lane < 4; lane++)
+						{
+							for (int i = 0; i < 3; i++)
+							{
+								w[i][lane] = origin[i] + (x - x0 + lane) * s.stepX[i];
+							}
+							if ((valid & (1 << lane)) && (accept || (w[0][lane] | w[1][lane] | w[2][lane]) >= 0))
+							{
+								mask |= 1 << lane;
+							}
+						}
+
+						__m128 w1 = _mm_set_ps((float)w[1][3], (float)w[1][2], (float)w[1][1], (float)w[1][0]);
+						__m128 w2 = _mm_set_ps((float)w[2][3], (float)w[2][2], (float)w[2][1], (float)w[2][0]);
+						if (mMultisample)
+						{
+							uint32_t coverage[4];
+							if (CoverSamples(planes, w, valid, coverage))
+							{
+								ShadeMultisample(s, interpolants, planes, x, y, coverage, w1, w2, shader);
+							}
+							continue;
+						}
+
+						if (mask)
+						{
+							ShadePacket(s, interpolants, x, y, mask, w1, w2, shader);
+						}
+					}
+
+					for (int i = 0; i < 3; i++)
+					{
+						origin[i] += s.stepY[i];
+					}
+				}
+			}
+		}
+	}
+
+	inline __m128i Rasterizer::PackPacket(const PacketFloat4& color)
+	{
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 scale = _mm_set1_ps(255.0f);
+		__m128 round = _mm_set1_ps(0.5f);
+		__m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color.x, zero), one), scale), round));
+		__m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color.y, zero), one), scale), round));
+		__m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color.z, zero), one), scale), round));
+		__m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color.w, zero), one), scale), round));
+		return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+	}
+
+	template<typename Shader>
+	void Rasterizer::ShadePacket(const Setup& s, const Interpolants& ip, int x, int y, int mask, __m128 w1, __m128 w2, const Shader& shader)
+	{
+		__m128 invArea = _mm_set1_ps(s.invArea);
+		__m128 l1 = _mm_mul_ps(w1, invArea);
+		__m128 l2 = _mm_mul_ps(w2, invArea);
+
+		auto interpolate = [&](int i)
+		{
+			return _mm_add_ps(ip.base[i], _mm_add_ps(_mm_mul_ps(l1, ip.d1[i]), _mm_mul_ps(l2, ip.d2[i])));
+		};
+
+		uint32_t index = (uint32_t)y * mWidth + (uint32_t)x;
+
+		// Early depth test, lanes past the row end are masked out and never touched. Packets inside the row are
+		// tested and written with all 4 lanes, lanes outside the mask keep their stored depth
+		// Transparent fragments are tested against opaque depth but never occlude each other
+		bool inside = (uint32_t)x + 4 <= mWidth;
+		__m128 lanes = _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_and_si128(_mm_set1_epi32(mask), _mm_set_epi32(8, 4, 2, 1)), _mm_setzero_si128()));
+		PixelPacket packet;
+		packet.z = interpolate(0);
+		if (mDepth)
+		{
+			float* depth = (float*)mDepth->GetData() + index;
+			bool write = !mFragments;
+			if (inside)
+			{
+				__m128 stored = _mm_loadu_ps(depth);
+				__m128 pass = _mm_and_ps(_mm_cmplt_ps(packet.z, stored), lanes);
+				mask = _mm_movemask_ps(pass);
+				lanes = pass;
+				if (write)
+				{
+					_mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(pass, packet.z), _mm_andnot_ps(pass, stored)));
+				}
+			}
+			else
+			{
+				float z[4];
+				_mm_storeu_ps(z, packet.z);
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if (mask & (1 << lane))
+					{
+						if (z[lane] < depth[lane])
+						{
+							if (write)
+							{
+								depth[lane] = z[lane];
+							}
+						}
+						else
+						{
+							mask &= ~(1 << lane);
+						}
+					}
+				}
+			}
+
+			if (!mask)
+			{
+				return;
+			}
+		}
+
+		if (ShaderTraits<Shader>::DepthOnly)
+		{
+			mStatistics.pixels += LaneCount(mask);
+			return;
+		}
+
+		packet.x = _mm_add_ps(_mm_set1_ps((float)(x + mOriginX)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+		packet.y = _mm_set1_ps((float)(y + mOriginY) + 0.5f);
+		packet.color.x = interpolate(1);
+		packet.color.y = interpolate(2);
+		packet.color.z = interpolate(3);
+		packet.color.w = interpolate(4);
+		packet.texcoord.x = interpolate(5);
+		packet.texcoord.y = interpolate(6);
+		packet.texcoord.z = interpolate(7);
+		packet.texcoord.w = interpolate(8);
+
+		PacketFloat4 result = shader(packet);
+
+		if (mFragments)
+		{
+			mFragments->Insert(index, mask, result, packet.z);
+		}
+		else if (mColor->GetElementSize() == 16)
+		{
+			_MM_TRANSPOSE4_PS(result.x, result.y, result.z, result.w);
+			__m128 pixels[4] = { result.x, result.y, result.z, result.w };
+			float* color = (float*)mColor->GetData() + (size_t)index * 4;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					_mm_storeu_ps(color + lane * 4, pixels[lane]);
+				}
+			}
+		}
+		else if (inside)
+		{
+			__m128i* color = (__m128i*)((uint32_t*)mColor->GetData() + index);
+			__m128i written = _mm_castps_si128(lanes);
+			_mm_storeu_si128(color, _mm_or_si128(_mm_and_si128(written, PackPacket(result)), _mm_andnot_si128(written, _mm_loadu_si128(color))));
+		}
+		else
+		{
+			uint32_t pixels[4];
+			_mm_storeu_si128((__m128i*)pixels, PackPacket(result));
+			uint32_t* color = (uint32_t*)mColor->GetData() + index;
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (mask & (1 << lane))
+				{
+					color[lane] = pixels[lane];
+				}
+			}
+		}
+
+		mStatistics.pixels += LaneCount(mask);
+	}
+
+	inline int Rasterizer::CoverSamples(const SamplePlanes& planes, const __m128i* w, int valid, uint32_t* coverage) const
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i validLanes = _mm_cmpgt_epi32(_mm_and_si128(_mm_set1_epi32(valid), _mm_set_epi32(8, 4, 2, 1)), zero);
+		__m128i fullMask = _mm_set1_epi32((1 << mMultisample->GetSampleCount()) - 1);
+
+		// Inside every edge at the sample nearest to it, all samples are covered
+		__m128i inner = _mm_or_si128(_mm_or_si128(_mm_add_epi32(w[0], planes.narrowLow[0]), _mm_add_epi32(w[1], planes.narrowLow[1])),
+			_mm_add_epi32(w[2], planes.narrowLow[2]));
+		__m128i innerLanes = _mm_andnot_si128(_mm_srai_epi32(inner, 31), validLanes);
+		__m128i covered = _mm_and_si128(innerLanes, fullMask);
+
+		// Outside one edge at the sample farthest into it, no sample is covered
+		__m128i outer = _mm_or_si128(_mm_or_si128(_mm_add_epi32(w[0], planes.narrowHigh[0]), _mm_add_epi32(w[1], planes.narrowHigh[1])),
+			_mm_add_epi32(w[2], planes.narrowHigh[2]));
+		__m128i partial = _mm_andnot_si128(_mm_or_si128(innerLanes, _mm_srai_epi32(outer, 31)), validLanes);
+
+		if (_mm_movemask_ps(_mm_castsi128_ps(partial)))
+		{
+			// Edge pixels, one sample of all 4 lanes at a time
+			__m128i samples = zero;
+			for (uint32_t i = 0; i < mMultisample->GetSampleCount(); i++)
+			{
+				__m128i e0 = _mm_add_epi32(w[0], _mm_set1_epi32((int32_t)planes.edge[0][i]));
+				__m128i e1 = _mm_add_epi32(w[1], _mm_set1_epi32((int32_t)planes.edge[1][i]));
+				__m128i e2 = _mm_add_epi32(w[2], _mm_set1_epi32((int32_t)planes.edge[2][i]));
+				__m128i sign = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31);
+				samples = _mm_or_si128(samples, _mm_andnot_si128(sign, _mm_set1_epi32(1 << i)));
+			}
+			covered = _mm_or_si128(covered, _mm_and_si128(samples, partial));
+		}
+
+		_mm_storeu_si128((__m128i*)coverage, covered);
+		return ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(covered, zero))) & 0xF;
+	}
+
+	inline int Rasterizer::CoverSamples(const SamplePlanes& planes, const int64_t (*w)[4], int valid, uint32_t* coverage) const
+	{
+		uint32_t sampleCount = mMultisample->GetSampleCount();
+		uint32_t fullMask = (1u << sampleCount) - 1;
+		int mask = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			coverage[lane] = 0;
+			if (!(valid & (1 << lane)))
+			{
+				continue;
+			}
+
+			if (((w[0][lane] + planes.low[0]) | (w[1][lane] + planes.low[1]) | (w[2][lane] + planes.low[2])) >= 0)
+			{
+				coverage[lane] = fullMask;
+			}
+			else if (w[0][lane] + planes.high[0] >= 0 && w[1][lane] + planes.high[1] >= 0 && w[2][lane] + planes.high[2] >= 0)
+			{
+				for (uint32_t i = 0; i < sampleCount; i++)
+				{
+					int64_t inside = (w[0][lane] + planes.edge[0][i]) | (w[1][lane] + planes.edge[1][i]) | (w[2][lane] + planes.edge[2][i]);
+					coverage[lane] |= inside >= 0 ? 1u << i : 0u;
+				}
+			}
+			mask |= coverage[lane] ? 1 << lane : 0;
+		}
+		return mask;
+	}
+
+	template<typename Shader>
+	void Rasterizer::ShadeMultisample(const Setup& s, const Interpolants& ip, const SamplePlanes& planes, int x, int y,
+		uint32_t* coverage, __m128 w1, __m128 w2, const Shader& shader)
+	{
+		__m128 invArea = _mm_set1_ps(s.invArea);
+		__m128 l1 = _mm_mul_ps(w1, invArea);
+		__m128 l2 = _mm_mul_ps(w2, invArea);
+
+		auto interpolate = [&](int i)
+		{
+			return _mm_add_ps(ip.base[i], _mm_add_ps(_mm_mul_ps(l1, ip.d1[i]), _mm_mul_ps(l2, ip.d2[i])));
+		};
+
+		// Early depth test per sample, depth planes are offset from the center depth
+		PixelPacket packet;
+		packet.z = interpolate(0);
+		int mask = mMultisample->DepthTestPacket((uint32_t)x, (uint32_t)y, coverage, packet.z, planes.depth);
+		if (!mask)
+		{
+			return;
+		}
+
+		mStatistics.pixels += LaneCount(mask);
+		if (ShaderTraits<Shader>::DepthOnly)
+		{
+			return;
+		}
+
+		// Shaded once at pixel centers, also when the center itself is outside the triangle
+		packet.x = _mm_add_ps(_mm_set1_ps((float)(x + mOriginX)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+		packet.y = _mm_set1_ps((float)(y + mOriginY) + 0.5f);
+		packet.color.x = interpolate(1);
+		packet.color.y = interpolate(2);
+		packet.color.z = interpolate(3);
+		packet.color.w = interpolate(4);
+		packet.texcoord.x = interpolate(5);
+		packet.texcoord.y = interpolate(6);
+		packet.texcoord.z = interpolate(7);
+		packet.texcoord.w = interpolate(8);
+
+		mMultisample->WriteColorPacket((uint32_t)x, (uint32_t)y, coverage, PackPacket(shader(packet)));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "ResolutionController.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Renderer
+{
+	ResolutionController::ResolutionController(uint32_t maxWidth, uint32_t maxHeight, float targetMs, float minScale, float maxScale)
+		: mMaxWidth(maxWidth), mMaxHeight(maxHeight), mTargetMs(targetMs), mMinScale(minScale), mMaxScale(maxScale),
+		mScale(maxScale), mAverageMs(0.0f)
+	{
+		UpdateSize();
+	}
+
+	void ResolutionController::UpdateSize()
+	{
+		mWidth = std::max(((uint32_t)(mMaxWidth * mScale) + 4) & ~7u, 8u);
+		mHeight = std::max(((uint32_t)(mMaxHeight * mScale) + 4) & ~7u, 8u);
+		mWidth = std::min(mWidth, mMaxWidth);
+		mHeight = std::min(mHeight, mMaxHeight);
+	}
+
+	bool ResolutionController::Update(float frameMs)
+	{
+		mAverageMs = mAverageMs == 0.0f ? frameMs : mAverageMs * 0.9f + frameMs * 0.1f;
+
+		float scale = mScale;
+		if (mAverageMs > mTargetMs || mAverageMs < mTargetMs * 0.8f)
+		{
+			float desired = mScale * sqrtf(mTargetMs / std::max(mAverageMs, 0.001f));
+			scale = std::min(std::max(desired, mScale * 0.9f), mScale * 1.1f);
+			scale = std::min(std::max(scale, mMinScale), mMaxScale);
+		}
+
+		uint32_t width = mWidth;
+		uint32_t height = mHeight;
+		mScale = scale;
+		UpdateSize();
+		if (width == mWidth && height == mHeight)
+		{
+			return false;
+		}
+
+		// Predict cost at the new size, otherwise the stale average keeps pushing in the same direction
+		mAverageMs *= (float)(mWidth * mHeight) / (float)(width * height);
+		return true;
+	}
+
+	void ResolutionController::PublishStatistics() const
+	{
+		Profiler& profiler = Profiler::Get();
+		profiler.Set("resolution.scale", mScale);
+		profiler.Set("resolution.width", mWidth);
+		profiler.Set("resolution.height", mHeight);
+		profiler.Set("resolution.frameMs", mAverageMs);
+	}
+}
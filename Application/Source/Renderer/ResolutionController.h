@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Renderer
+{
+	/**
+	 * @class ResolutionController
+	 * @brief Picks internal render resolution so that measured frame time stays within a budget.
+	 *
+	 * Frame time is smoothed with an exponential moving average and assumed proportional to pixel count, so the
+	 * scale needed to hit the target is scale * sqrt(target / average). The controller steps at most 10% per
+	 * frame, lowers resolution as soon as the budget is exceeded but raises it only below 80% of the budget, which
+	 * keeps it from oscillating around the target. Width and height are multiples of 8.
+	 */
+	class ResolutionController
+	{
+	protected:
+		uint32_t mMaxWidth;
+		uint32_t mMaxHeight;
+		float mTargetMs;
+		float mMinScale;
+		float mMaxScale;
+
+		float mScale;
+		float mAverageMs;
+		uint32_t mWidth;
+		uint32_t mHeight;
+
+		void UpdateSize();
+
+	public:
+		/**
+		 * @param maxWidth Resolution at scale 1.
+		 * @param targetMs Frame time budget.
+		 */
+		ResolutionController(uint32_t maxWidth, uint32_t maxHeight, float targetMs, float minScale = 0.5f, float maxScale = 1.0f);
+
+		/**
+		 * @brief Feeds render time of the last frame.
+		 * @return True if resolution changed and targets have to be resized.
+		 */
+		bool Update(float frameMs);
+
+		uint32_t GetWidth() const { return mWidth; }
+		uint32_t GetHeight() const { return mHeight; }
+		float GetScale() const { return mScale; }
+
+		/**
+		 * @brief Publishes resolution.scale, resolution.width, resolution.height and resolution.frameMs (smoothed).
+		 */
+		void PublishStatistics() const;
+	};
+}
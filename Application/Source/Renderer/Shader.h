@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Vertex.h"
+#include <emmintrin.h>
+#include <functional>
+
+namespace Renderer
+{
+	/**
+	 * @struct PacketFloat4
+	 * @brief Four float4 values in SoA layout, lane i belongs to pixel i of the packet.
+	 */
+	struct PacketFloat4
+	{
+		__m128 x;
+		__m128 y;
+		__m128 z;
+		__m128 w;
+	};
+
+	/**
+	 * @struct PixelPacket
+	 * @brief Pixel shader input, 4 horizontally adjacent pixels.
+	 */
+	struct PixelPacket
+	{
+		/** @brief Pixel center coordinates in screen space. */
+		__m128 x;
+		__m128 y;
+		/** @brief Interpolated depth. */
+		__m128 z;
+		/** @brief Interpolated vertex color. */
+		PacketFloat4 color;
+		/** @brief Interpolated texture coordinates. */
+		PacketFloat4 texcoord;
+	};
+
+	/**
+	 * @brief Pixel shaders are functors (or lambdas) callable as PacketFloat4(const PixelPacket&).
+	 *
+	 * Rasterizer::DrawTriangle is a template over the shader type, so the shader body is compiled straight into
+	 * the raster loop and inlined. Anything type erased (like DynamicPixelShader) still works, but pays an
+	 * indirect call per packet and blocks optimization across the call.
+	 */
+	struct VertexColorShader
+	{
+		PacketFloat4 operator()(const PixelPacket& packet) const
+		{
+			return packet.color;
+		}
+	};
+
+	typedef std::function<PacketFloat4(const PixelPacket&)> DynamicPixelShader;
+
+	/**
+	 * @brief Marker shader for depth-only passes (shadow maps, depth prepass), see Rasterizer::DrawTrianglesDepth.
+	 *
+	 * Only the depth plane is set up, covered pixels are depth tested and written, color target is never touched
+	 * and may be null.
+	 */
+	struct DepthOnlyShader
+	{
+		PacketFloat4 operator()(const PixelPacket& packet) const
+		{
+			return packet.color;
+		}
+	};
+
+	/**
+	 * @brief Compile-time properties of a pixel shader type, specialized for DepthOnlyShader.
+	 */
+	template<typename Shader>
+	struct ShaderTraits
+	{
+		static const bool DepthOnly = false;
+	};
+
+	template<>
+	struct ShaderTraits<DepthOnlyShader>
+	{
+		static const bool DepthOnly = true;
+	};
+
+	/**
+	 * @brief Vertex shaders are functors callable as Vertex(const Input&), transforming user vertex type into
+	 * screen space rasterizer vertex.
+	 */
+	struct PassThroughVertexShader
+	{
+		Vertex operator()(const Vertex& input) const
+		{
+			return input;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "ShadowMap.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Renderer
+{
+	ShadowMap::ShadowMap(uint32_t size)
+		: mSize(size), mDepth(sizeof(float), size * size), mRasterizer(nullptr, &mDepth, size, size)
+	{
+		SetLight(0.0f, 0.0f, size, size, 1.0f);
+	}
+
+	void ShadowMap::SetLight(float yaw, float pitch, uint32_t width, uint32_t height, float depthRange)
+	{
+		float cy = cosf(yaw);
+		float sy = sinf(yaw);
+		float cp = cosf(pitch);
+		float sp = sinf(pitch);
+
+		// Pitch after yaw, rows are light space axes in world space
+		float rotation[3][3] =
+		{
+			{ cy, 0.0f, sy },
+			{ sp * sy, cp, -sp * cy },
+			{ -cp * sy, sp, cp * cy }
+		};
+
+		// Fit orthographic projection to the world box, depth slightly inside (0, 1) so the clear value is farther
+		for (int r = 0; r < 3; r++)
+		{
+			float minimum = 0.0f;
+			float maximum = 0.0f;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				float x = (corner & 1) ? (float)width : 0.0f;
+				float y = (corner & 2) ? (float)height : 0.0f;
+				float z = (corner & 4) ? depthRange : 0.0f;
+				float value = rotation[r][0] * x + rotation[r][1] * y + rotation[r][2] * z;
+				minimum = corner == 0 ? value : std::min(minimum, value);
+				maximum = corner == 0 ? value : std::max(maximum, value);
+			}
+
+			float scale = (r < 2 ? (float)mSize : 0.998f) / std::max(maximum - minimum, 1e-6f);
+			float offset = r < 2 ? 0.0f : 0.001f;
+			mMatrix[r][0] = rotation[r][0] * scale;
+			mMatrix[r][1] = rotation[r][1] * scale;
+			mMatrix[r][2] = rotation[r][2] * depthRange * scale;
+			mMatrix[r][3] = offset - minimum * scale;
+		}
+	}
+
+	void ShadowMap::Render(const std::vector<Vertex>& vertices)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		mLightVertices.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Math::Numeric::float4& p = vertices[i].position;
+			Math::Numeric::float4& q = mLightVertices[i].position;
+			q.x = mMatrix[0][0] * p.x + mMatrix[0][1] * p.y + mMatrix[0][2] * p.z + mMatrix[0][3];
+			q.y = mMatrix[1][0] * p.x + mMatrix[1][1] * p.y + mMatrix[1][2] * p.z + mMatrix[1][3];
+			q.z = mMatrix[2][0] * p.x + mMatrix[2][1] * p.y + mMatrix[2][2] * p.z + mMatrix[2][3];
+			q.w = 1.0f;
+		}
+
+		float clear = 1.0f;
+		mDepth.Fill(&clear);
+		mRasterizer.ResetStatistics();
+		mRasterizer.DrawTrianglesDepth(mLightVertices.data(), nullptr, (uint32_t)(mLightVertices.size() / 3));
+
+		Profiler::Get().Set("shadow.ms", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		Profiler::Get().Set("shadow.pixels", (double)mRasterizer.GetStatistics().pixels);
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Rasterizer.h"
+#include "Shader.h"
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class ShadowMap
+	 * @brief Square depth map of the scene seen from a directional light, rendered with the depth-only kernel.
+	 *
+	 * Scenes are screen space, so the world is the box of screen width x height pixels with vertex depth
+	 * stretched to depthRange pixels. The light looks at that box from direction given by yaw and pitch
+	 * (0, 0 is the view direction) with an orthographic projection fitted to the box. The resulting affine
+	 * matrix maps screen (x, y, depth, 1) straight to shadow map (u, v, light depth), so the main pass
+	 * transforms interpolated pixel positions without any world position attribute.
+	 */
+	class ShadowMap
+	{
+	protected:
+		uint32_t mSize;
+		Buffer mDepth;
+		Rasterizer mRasterizer;
+		float mMatrix[3][4];
+		std::vector<Vertex> mLightVertices;
+
+	public:
+		ShadowMap(uint32_t size);
+
+		/**
+		 * @param yaw Rotation of light direction around the vertical axis, radians.
+		 * @param pitch Rotation of light direction around the horizontal axis, radians.
+		 * @param depthRange Depth 1 expressed in pixels, sets how far apart in depth the triangles are.
+		 */
+		void SetLight(float yaw, float pitch, uint32_t width, uint32_t height, float depthRange);
+
+		/**
+		 * @brief Clears map to 1 and renders triangle list given in screen space.
+		 */
+		void Render(const std::vector<Vertex>& vertices);
+
+		uint32_t GetSize() const { return mSize; }
+		const Buffer& GetDepth() const { return mDepth; }
+		const Rasterizer::Statistics& GetStatistics() const { return mRasterizer.GetStatistics(); }
+
+		/** @brief Row r of screen to shadow map transform. */
+		const float* GetMatrixRow(int r) const { return mMatrix[r]; }
+	};
+
+	/**
+	 * @struct ShadowShader
+	 * @brief Vertex color attenuated by 2x2 percentage closer filtered shadow map lookup.
+	 *
+	 * Four lanes gather their 2x2 texel footprints, the 16 depth compares are 4 SSE compares and the results
+	 * are blended bilinearly, so shadow edges are smooth at texel scale.
+	 */
+	struct ShadowShader
+	{
+		__m128 matrix[3][4];
+		const float* depth;
+		int size;
+		__m128 maxCoordinate;
+		__m128 bias;
+		__m128 ambient;
+
+		ShadowShader(const ShadowMap& map, float depthBias = 0.015f, float ambientLight = 0.3f)
+		{
+			for (int r = 0; r < 3; r++)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					matrix[r][c] = _mm_set1_ps(map.GetMatrixRow(r)[c]);
+				}
+			}
+			depth = (const float*)map.GetDepth().GetData();
+			size = (int)map.GetSize();
+			maxCoordinate = _mm_set1_ps(size - 1.001f);
+			bias = _mm_set1_ps(depthBias);
+			ambient = _mm_set1_ps(ambientLight);
+		}
+
+		/**
+		 * @brief Fraction of light reaching screen positions, 0 fully shadowed, 1 fully lit.
+		 */
+		__m128 Visibility(__m128 x, __m128 y, __m128 z) const
+		{
+			__m128 half = _mm_set1_ps(0.5f);
+			__m128 zero = _mm_setzero_ps();
+			__m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[0][0], x), _mm_mul_ps(matrix[0][1], y)), _mm_add_ps(_mm_mul_ps(matrix[0][2], z), matrix[0][3]));
+			__m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[1][0], x), _mm_mul_ps(matrix[1][1], y)), _mm_add_ps(_mm_mul_ps(matrix[1][2], z), matrix[1][3]));
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(matrix[2][0], x), _mm_mul_ps(matrix[2][1], y)), _mm_add_ps(_mm_mul_ps(matrix[2][2], z), matrix[2][3]));
+			d = _mm_sub_ps(d, bias);
+
+			// Texel centers are at +0.5, clamping keeps the 2x2 footprint inside the map
+			u = _mm_min_ps(_mm_max_ps(_mm_sub_ps(u, half), zero), maxCoordinate);
+			v = _mm_min_ps(_mm_max_ps(_mm_sub_ps(v, half), zero), maxCoordinate);
+			__m128i x0 = _mm_cvttps_epi32(u);
+			__m128i y0 = _mm_cvttps_epi32(v);
+			__m128 fx = _mm_sub_ps(u, _mm_cvtepi32_ps(x0));
+			__m128 fy = _mm_sub_ps(v, _mm_cvtepi32_ps(y0));
+
+			int xs[4];
+			int ys[4];
+			_mm_storeu_si128((__m128i*)xs, x0);
+			_mm_storeu_si128((__m128i*)ys, y0);
+
+			float t00[4];
+			float t10[4];
+			float t01[4];
+			float t11[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				const float* texel = depth + ys[lane] * size + xs[lane];
+				t00[lane] = texel[0];
+				t10[lane] = texel[1];
+				t01[lane] = texel[size];
+				t11[lane] = texel[size + 1];
+			}
+
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 c00 = _mm_and_ps(_mm_cmple_ps(d, _mm_loadu_ps(t00)), one);
+			__m128 c10 = _mm_and_ps(_mm_cmple_ps(d, _mm_loadu_ps(t10)), one);
+			__m128 c01 = _mm_and_ps(_mm_cmple_ps(d, _mm_loadu_ps(t01)), one);
+			__m128 c11 = _mm_and_ps(_mm_cmple_ps(d, _mm_loadu_ps(t11)), one);
+
+			__m128 top = _mm_add_ps(c00, _mm_mul_ps(fx, _mm_sub_ps(c10, c00)));
+			__m128 bottom = _mm_add_ps(c01, _mm_mul_ps(fx, _mm_sub_ps(c11, c01)));
+			return _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top)));
+		}
+
+		PacketFloat4 operator()(const PixelPacket& packet) const
+		{
+			__m128 visibility = Visibility(packet.x, packet.y, packet.z);
+			__m128 light = _mm_add_ps(ambient, _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), ambient), visibility));
+
+			PacketFloat4 result;
+			result.x = _mm_mul_ps(packet.color.x, light);
+			result.y = _mm_mul_ps(packet.color.y, light);
+			result.z = _mm_mul_ps(packet.color.z, light);
+			result.w = packet.color.w;
+			return result;
+		}
+	};
+}
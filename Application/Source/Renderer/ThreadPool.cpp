@@ -0,0 +1,222 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace Renderer
+{
+	ThreadPool::ThreadPool(uint32_t threads)
+		: mTask(nullptr), mCount(0), mNext(0), mActive(0), mGeneration(0), mExit(false), mPartitioned(false), mPinned(false)
+#ifdef __linux__
+		, mCallerSaved(false)
+#endif
+	{
+		if (threads == 0)
+		{
+			threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		// Until pinned everything is one node
+		mThreadNodes.assign(threads, 0);
+		mNodeThreads.assign(1, threads);
+		mNodeNext.reset(new std::atomic<uint32_t>[1]);
+		mNodeEnd.assign(1, 0);
+
+		for (uint32_t i = 1; i < threads; i++)
+		{
+			mThreads.push_back(std::thread(&ThreadPool::Worker, this, i));
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mExit = true;
+		}
+		mWake.notify_all();
+
+		for (std::thread& thread : mThreads)
+		{
+			thread.join();
+		}
+
+#ifdef __linux__
+		if (mCallerSaved)
+		{
+			pthread_setaffinity_np(mCaller, sizeof(mCallerAffinity), &mCallerAffinity);
+		}
+#endif
+	}
+
+	void ThreadPool::Worker(uint32_t thread)
+	{
+		uint64_t generation = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [&]() { return mExit || mGeneration != generation; });
+				if (mExit)
+				{
+					return;
+				}
+				generation = mGeneration;
+			}
+
+			Execute(thread);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mActive == 0)
+			{
+				mDone.notify_all();
+			}
+		}
+	}
+
+	void ThreadPool::Execute(uint32_t thread)
+	{
+		if (!mPartitioned)
+		{
+			for (uint32_t i = mNext++; i < mCount; i = mNext++)
+			{
+				(*mTask)(i, thread);
+			}
+			return;
+		}
+
+		// Own node first, then steal from the following ones
+		uint32_t nodes = GetNodeCount();
+		for (uint32_t k = 0; k < nodes; k++)
+		{
+			uint32_t node = (mThreadNodes[thread] + k) % nodes;
+			for (uint32_t i = mNodeNext[node]++; i < mNodeEnd[node]; i = mNodeNext[node]++)
+			{
+				(*mTask)(i, thread);
+			}
+		}
+	}
+
+	bool ThreadPool::Pin(const CpuTopology& topology)
+	{
+#ifdef __linux__
+		if (!topology.detected || topology.cpus.empty())
+		{
+			return false;
+		}
+
+		if (!mCallerSaved)
+		{
+			mCaller = pthread_self();
+			mCallerSaved = pthread_getaffinity_np(mCaller, sizeof(mCallerAffinity), &mCallerAffinity) == 0;
+			if (!mCallerSaved)
+			{
+				return false;
+			}
+		}
+
+		std::vector<uint32_t> order = topology.GetPinningOrder();
+		bool pinned = true;
+		for (uint32_t t = 0; t < GetThreadCount(); t++)
+		{
+			const CpuTopology::Cpu& cpu = topology.cpus[order[t % order.size()]];
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu.id, &set);
+			pthread_t handle = t == 0 ? mCaller : mThreads[t - 1].native_handle();
+			pinned &= pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+			mThreadNodes[t] = cpu.node;
+		}
+
+		mNodeThreads.assign(topology.nodeCount, 0);
+		for (uint32_t node : mThreadNodes)
+		{
+			mNodeThreads[node]++;
+		}
+		mNodeNext.reset(new std::atomic<uint32_t>[topology.nodeCount]);
+		mNodeEnd.assign(topology.nodeCount, 0);
+		mPinned = pinned;
+		return pinned;
+#else
+		(void)topology;
+		return false;
+#endif
+	}
+
+	void ThreadPool::GetNodeRange(uint32_t count, uint32_t node, uint32_t& begin, uint32_t& end) const
+	{
+		// Parts proportional to thread count, nodes without threads own nothing
+		uint32_t before = 0;
+		for (uint32_t n = 0; n < node; n++)
+		{
+			before += mNodeThreads[n];
+		}
+		uint32_t threads = GetThreadCount();
+		begin = (uint32_t)((uint64_t)count * before / threads);
+		end = (uint32_t)((uint64_t)count * (before + mNodeThreads[node]) / threads);
+	}
+
+	uint32_t ThreadPool::GetNode(uint32_t count, uint32_t index) const
+	{
+		for (uint32_t n = 0; n < GetNodeCount(); n++)
+		{
+			uint32_t begin;
+			uint32_t end;
+			GetNodeRange(count, n, begin, end);
+			if (index < end)
+			{
+				return n;
+			}
+		}
+		return GetNodeCount() - 1;
+	}
+
+	void ThreadPool::ParallelForNodes(uint32_t count, const Task& task)
+	{
+		if (GetNodeCount() == 1)
+		{
+			ParallelFor(count, task);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for (uint32_t n = 0; n < GetNodeCount(); n++)
+			{
+				uint32_t begin;
+				GetNodeRange(count, n, begin, mNodeEnd[n]);
+				mNodeNext[n] = begin;
+			}
+			mPartitioned = true;
+		}
+		ParallelFor(count, task);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPartitioned = false;
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, const Task& task)
+	{
+		if (mThreads.empty() || count <= 1)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				task(i, 0);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTask = &task;
+			mCount = count;
+			mNext = 0;
+			mActive = (uint32_t)mThreads.size();
+			mGeneration++;
+		}
+		mWake.notify_all();
+
+		Execute(0);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDone.wait(lock, [&]() { return mActive == 0; });
+	}
+}
\ No newline at end of file
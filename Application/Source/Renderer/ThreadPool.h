@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CpuTopology.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Renderer
+{
+	/**
+	 * @class ThreadPool
+	 * @brief Fixed set of worker threads executing parallel loops, calling thread takes part as thread 0.
+	 *
+	 * Threads can be pinned to CPUs in topology order, then every thread knows its NUMA node. ParallelForNodes
+	 * splits the index range into one contiguous part per node (sized by thread count on it), threads take
+	 * indices of their own node first and only then steal from the others.
+	 */
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void(uint32_t index, uint32_t thread)> Task;
+
+	protected:
+		std::vector<std::thread> mThreads;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+
+		const Task* mTask;
+		uint32_t mCount;
+		std::atomic<uint32_t> mNext;
+		uint32_t mActive;
+		uint64_t mGeneration;
+		bool mExit;
+
+		// Node partitioned loops, one claim counter and range end per node
+		std::vector<uint32_t> mThreadNodes;
+		std::vector<uint32_t> mNodeThreads;
+		std::unique_ptr<std::atomic<uint32_t>[]> mNodeNext;
+		std::vector<uint32_t> mNodeEnd;
+		bool mPartitioned;
+		bool mPinned;
+#ifdef __linux__
+		// Affinity of the thread that called Pin, given back when the pool goes away
+		pthread_t mCaller;
+		cpu_set_t mCallerAffinity;
+		bool mCallerSaved;
+#endif
+
+		void Worker(uint32_t thread);
+		void Execute(uint32_t thread);
+
+	public:
+		/**
+		 * @param threads Total thread count including the caller, 0 uses hardware concurrency.
+		 */
+		ThreadPool(uint32_t threads = 0);
+		virtual ~ThreadPool();
+
+		/**
+		 * @brief Calls task for every index in [0, count) and waits for completion.
+		 */
+		void ParallelFor(uint32_t count, const Task& task);
+
+		/**
+		 * @brief Like ParallelFor, index i belongs to node GetNode(count, i) and is preferably run by its threads.
+		 */
+		void ParallelForNodes(uint32_t count, const Task& task);
+
+		/**
+		 * @brief Pins thread t (caller included) to CPU GetPinningOrder()[t % CPUs], false where unsupported.
+		 *
+		 * Calling thread keeps its pin until the pool is destroyed, then gets its previous affinity back. It must
+		 * be the thread running ParallelFor and outlive the pool.
+		 */
+		bool Pin(const CpuTopology& topology);
+
+		/**
+		 * @brief Node owning index of a ParallelForNodes loop over count indices.
+		 */
+		uint32_t GetNode(uint32_t count, uint32_t index) const;
+
+		/**
+		 * @brief Contiguous index range [begin, end) of node in a ParallelForNodes loop over count indices.
+		 */
+		void GetNodeRange(uint32_t count, uint32_t node, uint32_t& begin, uint32_t& end) const;
+
+		uint32_t GetThreadNode(uint32_t thread) const { return mThreadNodes[thread]; }
+		uint32_t GetNodeCount() const { return (uint32_t)mNodeThreads.size(); }
+		bool IsPinned() const { return mPinned; }
+
+		uint32_t GetThreadCount() const { return (uint32_t)mThreads.size() + 1; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Renderer
+{
+	/**
+	 * @struct Rect
+	 * @brief Axis aligned pixel rectangle, [x, x + width) x [y, y + height).
+	 */
+	struct Rect
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	/**
+	 * @class TileGrid
+	 * @brief Splits a width x height surface into square tiles, the last row/column of tiles may be partial.
+	 */
+	class TileGrid
+	{
+	protected:
+		uint32_t mWidth;
+		uint32_t mHeight;
+		uint32_t mTileSize;
+		uint32_t mTilesX;
+		uint32_t mTilesY;
+
+	public:
+		TileGrid(uint32_t width, uint32_t height, uint32_t tileSize = 64)
+			: mWidth(width), mHeight(height), mTileSize(tileSize)
+		{
+			mTilesX = (mWidth + mTileSize - 1) / mTileSize;
+			mTilesY = (mHeight + mTileSize - 1) / mTileSize;
+		}
+
+		/**
+		 * @brief Gets pixel rectangle covered by tile, clipped against surface size.
+		 * @param tile Linear tile index (row major).
+		 */
+		Rect GetTileRect(uint32_t tile) const
+		{
+			Rect r;
+			r.x = (tile % mTilesX) * mTileSize;
+			r.y = (tile / mTilesX) * mTileSize;
+			r.width = (r.x + mTileSize > mWidth) ? mWidth - r.x : mTileSize;
+			r.height = (r.y + mTileSize > mHeight) ? mHeight - r.y : mTileSize;
+			return r;
+		}
+
+		uint32_t GetWidth() const { return mWidth; }
+		uint32_t GetHeight() const { return mHeight; }
+		uint32_t GetTileSize() const { return mTileSize; }
+		uint32_t GetTilesX() const { return mTilesX; }
+		uint32_t GetTilesY() const { return mTilesY; }
+		uint32_t GetTileCount() const { return mTilesX * mTilesY; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,766 @@
+#include "TileRenderer.h"
+#include "Color.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <functional>
+
+namespace Renderer
+{
+	using Math::Numeric::float4;
+
+	namespace
+	{
+		// Yields before a stalled binner or producer blocks, covers a batch being transformed or binned
+		const int SpinCount = 64;
+
+		uint64_t Nanoseconds(std::chrono::steady_clock::time_point start)
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		uint32_t VertexCount(TileRenderer::Topology topology)
+		{
+			switch (topology)
+			{
+			case TileRenderer::Topology::Lines:
+				return 2;
+			case TileRenderer::Topology::Points:
+				return 1;
+			default:
+				return 3;
+			}
+		}
+
+		// Narrows a line's tile columns to the ones it passes within margin pixels of inside tile row ty
+		void LineColumns(const Vertex* v, uint32_t ty, int tileSize, float margin, uint32_t& tx0, uint32_t& tx1)
+		{
+			float ax = v[0].position.x;
+			float ay = v[0].position.y;
+			float bx = v[1].position.x;
+			float by = v[1].position.y;
+			if (ay > by)
+			{
+				std::swap(ax, bx);
+				std::swap(ay, by);
+			}
+			if (ay == by)
+			{
+				return;
+			}
+
+			float top = std::max((float)(ty * tileSize) - margin, ay);
+			float bottom = std::min((float)((ty + 1) * tileSize) + margin, by);
+			float slope = (bx - ax) / (by - ay);
+			float x0 = ax + (top - ay) * slope;
+			float x1 = ax + (bottom - ay) * slope;
+			if (x0 > x1)
+			{
+				std::swap(x0, x1);
+			}
+			tx0 = std::max(tx0, (uint32_t)(std::max((int)floorf(x0 - margin), 0) / tileSize));
+			tx1 = std::min(tx1, (uint32_t)(std::max((int)(x1 + margin), 0) / tileSize));
+		}
+	}
+
+	TileRenderer::TileRenderer(uint32_t width, uint32_t height, ThreadPool* pool, uint32_t tileSize, uint32_t queueCapacity)
+		: mGrid(width, height, tileSize), mPool(pool), mDiscardDepth(true), mTopology(Topology::Triangles),
+		mLineAntialiasing(false), mPointSize(1.0f), mFragmentsPerPixel(4), mCapture(nullptr),
+		mArenas(pool ? pool->GetThreadCount() : 1), mColorElementSize(0),
+		mQueue(queueCapacity), mFrameActive(false), mExit(false), mClosed(false), mBinnerSleeping(false), mProducersSleeping(0),
+		mProducerStall(0), mBinnerStall(0), mDepthSum(0), mDepthMax(0), mBatches(0)
+	{
+		mWorkers.resize(mArenas.GetCount());
+
+		uint32_t nodes = pool ? pool->GetNodeCount() : 1;
+		mNodeBandwidth.resize(nodes);
+		for (uint32_t n = 0; n < nodes; n++)
+		{
+			mNodeKeys.push_back("numa.node" + std::to_string(n) + ".writeGBs");
+		}
+	}
+
+	TileRenderer::~TileRenderer()
+	{
+		if (mBinner.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mExit = true;
+			}
+			mWake.notify_all();
+			mBinner.join();
+		}
+	}
+
+	void TileRenderer::BinPrimitives(ChunkBins& bins, LinearArena& arena, const Vertex* vertices, uint32_t primitiveCount)
+	{
+		uint32_t tileCount = mGrid.GetTileCount();
+		float width = (float)mGrid.GetWidth();
+		float height = (float)mGrid.GetHeight();
+		int tileSize = (int)mGrid.GetTileSize();
+		uint32_t tilesX = mGrid.GetTilesX();
+		uint32_t stride = VertexCount(mTopology);
+
+		// Aliased lines stay inside their bounding box, antialiased ones touch the pixel next to the line, points
+		// extend half their size around the vertex
+		float padding = 0.0f;
+		if (mTopology == Topology::Lines && mLineAntialiasing)
+		{
+			padding = 1.0f;
+		}
+		else if (mTopology == Topology::Points)
+		{
+			padding = mPointSize * 0.5f + 1.0f;
+		}
+
+		// Diagonal lines go only to tiles along them instead of their whole bounding box, pixels stay within one
+		// pixel of the segment
+		bool lines = mTopology == Topology::Lines;
+		float margin = padding + 1.0f;
+
+		// Power of two tiles (the default) are indexed with a shift, a division per bound dominates binning of
+		// small primitives
+		int shift = -1;
+		for (int s = 0; s < 16; s++)
+		{
+			shift = tileSize == (1 << s) ? s : shift;
+		}
+		auto tileOf = [&](int pixel)
+		{
+			return shift >= 0 ? pixel >> shift : pixel / tileSize;
+		};
+
+		// First pass stores tile range of every primitive and counts primitives per tile, most primitives touch a
+		// single tile and skip the loops
+		bins.vertices = vertices;
+		bins.offsets = arena.Allocate<uint32_t>(tileCount + 1);
+		memset(bins.offsets, 0, (tileCount + 1) * sizeof(uint32_t));
+		TileRange* ranges = arena.Allocate<TileRange>(primitiveCount);
+
+		// Bounds of four primitives are found at once, they are clamped to the target before conversion so far off
+		// screen vertices can't overflow
+		__m128 zero = _mm_setzero_ps();
+		__m128 padding4 = _mm_set1_ps(padding);
+		__m128 width4 = _mm_set1_ps(width);
+		__m128 height4 = _mm_set1_ps(height);
+		__m128 right = _mm_set1_ps(width - 1.0f);
+		__m128 bottom = _mm_set1_ps(height - 1.0f);
+
+		for (uint32_t group = 0; group < primitiveCount; group += 4)
+		{
+			const Vertex* v[4];
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				v[k] = &vertices[std::min(group + k, primitiveCount - 1) * stride];
+			}
+
+			__m128 minX = zero;
+			__m128 minY = zero;
+			__m128 maxX = zero;
+			__m128 maxY = zero;
+			for (uint32_t i = 0; i < stride; i++)
+			{
+				__m128 xy01 = _mm_unpacklo_ps(_mm_loadu_ps(&v[0][i].position.x), _mm_loadu_ps(&v[1][i].position.x));
+				__m128 xy23 = _mm_unpacklo_ps(_mm_loadu_ps(&v[2][i].position.x), _mm_loadu_ps(&v[3][i].position.x));
+				__m128 x = _mm_movelh_ps(xy01, xy23);
+				__m128 y = _mm_movehl_ps(xy23, xy01);
+				minX = i ? _mm_min_ps(minX, x) : x;
+				minY = i ? _mm_min_ps(minY, y) : y;
+				maxX = i ? _mm_max_ps(maxX, x) : x;
+				maxY = i ? _mm_max_ps(maxY, y) : y;
+			}
+			minX = _mm_sub_ps(minX, padding4);
+			minY = _mm_sub_ps(minY, padding4);
+			maxX = _mm_add_ps(maxX, padding4);
+			maxY = _mm_add_ps(maxY, padding4);
+			int outside = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmplt_ps(maxX, zero), _mm_cmplt_ps(maxY, zero)),
+				_mm_or_ps(_mm_cmpge_ps(minX, width4), _mm_cmpge_ps(minY, height4))));
+
+			int bounds[4][4];
+			_mm_storeu_si128((__m128i*)bounds[0], _mm_cvttps_epi32(_mm_max_ps(minX, zero)));
+			_mm_storeu_si128((__m128i*)bounds[1], _mm_cvttps_epi32(_mm_max_ps(minY, zero)));
+			_mm_storeu_si128((__m128i*)bounds[2], _mm_cvttps_epi32(_mm_min_ps(maxX, right)));
+			_mm_storeu_si128((__m128i*)bounds[3], _mm_cvttps_epi32(_mm_min_ps(maxY, bottom)));
+
+			for (uint32_t k = 0; k < 4 && group + k < primitiveCount; k++)
+			{
+				TileRange& range = ranges[group + k];
+				if (outside & (1 << k))
+				{
+					range.x0 = 1;
+					range.x1 = 0;
+					continue;
+				}
+
+				range.x0 = (uint16_t)tileOf(bounds[0][k]);
+				range.y0 = (uint16_t)tileOf(bounds[1][k]);
+				range.x1 = (uint16_t)tileOf(bounds[2][k]);
+				range.y1 = (uint16_t)tileOf(bounds[3][k]);
+				if (range.x0 == range.x1 && range.y0 == range.y1)
+				{
+					bins.offsets[range.y0 * tilesX + range.x0 + 1]++;
+					continue;
+				}
+
+				bool diagonal = lines && range.x0 < range.x1 && range.y0 != range.y1;
+				for (uint32_t ty = range.y0; ty <= range.y1; ty++)
+				{
+					uint32_t x0 = range.x0;
+					uint32_t x1 = range.x1;
+					if (diagonal)
+					{
+						LineColumns(v[k], ty, tileSize, margin, x0, x1);
+					}
+					for (uint32_t tx = x0; tx <= x1; tx++)
+					{
+						bins.offsets[ty * tilesX + tx + 1]++;
+					}
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < tileCount; i++)
+		{
+			bins.offsets[i + 1] += bins.offsets[i];
+		}
+
+		// Second pass scatters primitives, submission order is kept within every bin
+		bins.primitives = arena.Allocate<uint32_t>(bins.offsets[tileCount]);
+		uint32_t* cursor = arena.Allocate<uint32_t>(tileCount);
+		memcpy(cursor, bins.offsets, tileCount * sizeof(uint32_t));
+
+		for (uint32_t t = 0; t < primitiveCount; t++)
+		{
+			const TileRange& range = ranges[t];
+			if (range.x0 == range.x1 && range.y0 == range.y1)
+			{
+				bins.primitives[cursor[range.y0 * tilesX + range.x0]++] = t * stride;
+				continue;
+			}
+
+			bool diagonal = lines && range.x0 < range.x1 && range.y0 != range.y1;
+			for (uint32_t ty = range.y0; range.x0 <= range.x1 && ty <= range.y1; ty++)
+			{
+				uint32_t x0 = range.x0;
+				uint32_t x1 = range.x1;
+				if (diagonal)
+				{
+					LineColumns(&vertices[t * stride], ty, tileSize, margin, x0, x1);
+				}
+				for (uint32_t tx = x0; tx <= x1; tx++)
+				{
+					bins.primitives[cursor[ty * tilesX + tx]++] = t * stride;
+				}
+			}
+		}
+	}
+
+	void TileRenderer::Bin(const std::vector<Vertex>& vertices, std::vector<ChunkBins>& chunks)
+	{
+		uint32_t stride = VertexCount(mTopology);
+		uint32_t primitiveCount = (uint32_t)(vertices.size() / stride);
+		uint32_t chunkCount = mArenas.GetCount();
+		chunks.resize(chunkCount);
+
+		auto task = [&](uint32_t chunk, uint32_t thread)
+		{
+			uint32_t first = (uint32_t)((uint64_t)primitiveCount * chunk / chunkCount);
+			uint32_t end = (uint32_t)((uint64_t)primitiveCount * (chunk + 1) / chunkCount);
+			chunks[chunk].sequence = chunk;
+			BinPrimitives(chunks[chunk], mArenas.Get(thread), vertices.data() + (size_t)first * stride, end - first);
+		};
+
+		// By reference, so wrapping the lambda into ThreadPool::Task does not allocate
+		if (mPool)
+		{
+			mPool->ParallelFor(chunkCount, std::ref(task));
+		}
+		else
+		{
+			task(0, 0);
+		}
+	}
+
+	void TileRenderer::BinnerLoop()
+	{
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWake.wait(lock, [&]() { return mExit || mFrameActive; });
+				if (mExit)
+				{
+					return;
+				}
+			}
+
+			// An empty queue while the frame is open only means producers are still transforming
+			Batch batch;
+			int spins = 0;
+			for (;;)
+			{
+				// Every Submit returned before close, so once closed an empty queue is really drained
+				bool closed = mClosed.load(std::memory_order_acquire);
+				if (mQueue.TryPop(batch))
+				{
+					WakeProducers();
+					mChunks.push_back(ChunkBins());
+					mChunks.back().sequence = batch.sequence;
+					BinPrimitives(mChunks.back(), mBinnerArena, batch.vertices, batch.vertexCount / 3);
+					spins = 0;
+					continue;
+				}
+
+				if (closed)
+				{
+					break;
+				}
+
+				auto start = std::chrono::steady_clock::now();
+				if (++spins < SpinCount)
+				{
+					std::this_thread::yield();
+				}
+				else
+				{
+					// Flag is set before the queue is checked again and Submit pushes before reading it, so
+					// with both fences one of them sees the other
+					std::unique_lock<std::mutex> lock(mMutex);
+					mBinnerSleeping = true;
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					mQueueReady.wait(lock, [&]() { return mQueue.GetSize() > 0 || mClosed.load(std::memory_order_acquire); });
+					mBinnerSleeping = false;
+					spins = 0;
+				}
+				mBinnerStall += Nanoseconds(start);
+			}
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFrameActive = false;
+			mDone.notify_all();
+		}
+	}
+
+	void TileRenderer::WakeProducers()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mProducersSleeping.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQueueSpace.notify_all();
+		}
+	}
+
+	void TileRenderer::BeginFrame()
+	{
+		if (!mBinner.joinable())
+		{
+			mBinner = std::thread(&TileRenderer::BinnerLoop, this);
+		}
+
+		// Bins of the previous frame are dead, all arenas are released in one go
+		mArenas.Reset();
+		mBinnerArena.Reset();
+		mChunks.clear();
+		mTransparentChunks.clear();
+		mTopology = Topology::Triangles;
+
+		mClosed = false;
+		mProducerStall = 0;
+		mBinnerStall = 0;
+		mDepthSum = 0;
+		mDepthMax = 0;
+		mBatches = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFrameActive = true;
+		}
+		mWake.notify_all();
+	}
+
+	void TileRenderer::Submit(const Vertex* vertices, uint32_t vertexCount, uint32_t sequence)
+	{
+		Batch batch = { vertices, vertexCount, sequence };
+		if (!mQueue.TryPush(batch))
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int spins = 1; !mQueue.TryPush(batch); spins++)
+			{
+				if (spins < SpinCount)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mMutex);
+				mProducersSleeping++;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				mQueueSpace.wait(lock, [&]() { return mQueue.GetSize() < mQueue.GetCapacity(); });
+				mProducersSleeping--;
+				spins = 0;
+			}
+			mProducerStall += Nanoseconds(start);
+		}
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mBinnerSleeping.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQueueReady.notify_one();
+		}
+
+		uint32_t depth = (uint32_t)mQueue.GetSize();
+		mDepthSum += depth;
+		mBatches++;
+		uint32_t max = mDepthMax.load(std::memory_order_relaxed);
+		while (depth > max && !mDepthMax.compare_exchange_weak(max, depth, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void TileRenderer::EndFrame(const float4& clearColor, float clearDepth, Buffer& color, Buffer* depth)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mClosed.store(true, std::memory_order_release);
+			mQueueReady.notify_one();
+			mDone.wait(lock, [&]() { return !mFrameActive; });
+		}
+
+		std::sort(mChunks.begin(), mChunks.end(), [](const ChunkBins& a, const ChunkBins& b) { return a.sequence < b.sequence; });
+
+		RenderTiles(clearColor, clearDepth, color, depth);
+
+		Profiler& profiler = Profiler::Get();
+		uint32_t batches = mBatches;
+		profiler.Set("queue.batches", (double)batches);
+		profiler.Set("queue.depthMax", (double)mDepthMax);
+		profiler.Set("queue.depthAverage", batches ? (double)mDepthSum / batches : 0.0);
+		profiler.Set("queue.producerStallMs", (double)mProducerStall * 1e-6);
+		profiler.Set("queue.binnerStallMs", (double)mBinnerStall * 1e-6);
+		profiler.Set("arena.binnerBytes", (double)mBinnerArena.GetUsed());
+	}
+
+	void TileRenderer::WriteBack(const Buffer& source, Buffer& destination, const Rect& rect)
+	{
+		uint32_t elementSize = destination.GetElementSize();
+		uint32_t rowBytes = rect.width * elementSize;
+		uint32_t tileSize = mGrid.GetTileSize();
+
+		for (uint32_t row = 0; row < rect.height; row++)
+		{
+			const uint8_t* src = (const uint8_t*)source.GetData() + (size_t)row * tileSize * elementSize;
+			uint8_t* dst = (uint8_t*)destination.GetData() + ((size_t)(rect.y + row) * mGrid.GetWidth() + rect.x) * elementSize;
+
+			// Streaming stores bypass cache, finished tile is never read back this frame
+			if ((((uintptr_t)src | (uintptr_t)dst | rowBytes) & 15) == 0)
+			{
+				for (uint32_t i = 0; i < rowBytes; i += 16)
+				{
+					_mm_stream_si128((__m128i*)(dst + i), _mm_load_si128((const __m128i*)(src + i)));
+				}
+			}
+			else
+			{
+				memcpy(dst, src, rowBytes);
+			}
+		}
+	}
+
+	void TileRenderer::RenderTile(uint32_t tile, Worker& worker, const void* clearColor, float clearDepth, Buffer& color, Buffer* depth)
+	{
+		Rect r = mGrid.GetTileRect(tile);
+		if (mPool && mPool->GetNodeCount() > 1 && mPool->GetNode(mGrid.GetTileCount(), tile) != mPool->GetThreadNode((uint32_t)(&worker - mWorkers.data())))
+		{
+			worker.stolenTiles++;
+		}
+
+		worker.color->Fill(clearColor);
+		worker.depth->Fill(&clearDepth);
+
+		Rect scissor = { 0, 0, r.width, r.height };
+		worker.rasterizer->SetOrigin((int)r.x, (int)r.y);
+		worker.rasterizer->SetScissor(scissor);
+		// Chunks are sorted by sequence, walking them in order keeps submission order
+		Rasterizer& rasterizer = *worker.rasterizer;
+		for (const ChunkBins& bins : mChunks)
+		{
+			// Bin entries are vertex offsets, so lines and triangles of a bin are drawn as one batch
+			uint32_t begin = bins.offsets[tile];
+			uint32_t count = bins.offsets[tile + 1] - begin;
+			if (mTopology == Topology::Lines)
+			{
+				rasterizer.DrawLines(bins.vertices, bins.primitives + begin, count);
+			}
+			else if (mTopology == Topology::Triangles)
+			{
+				rasterizer.DrawTriangles(bins.vertices, bins.primitives + begin, count);
+			}
+			else
+			{
+				for (uint32_t i = begin; i < begin + count; i++)
+				{
+					rasterizer.DrawPoint(bins.vertices[bins.primitives[i]]);
+				}
+			}
+		}
+
+		if (!mTransparentChunks.empty())
+		{
+			worker.fragments->Clear();
+			rasterizer.SetFragmentBuffer(worker.fragments.get());
+			for (const ChunkBins& bins : mTransparentChunks)
+			{
+				uint32_t begin = bins.offsets[tile];
+				rasterizer.DrawTriangles(bins.vertices, bins.primitives + begin, bins.offsets[tile + 1] - begin);
+			}
+			rasterizer.SetFragmentBuffer(nullptr);
+			worker.fragments->Resolve(*worker.color);
+		}
+
+		// Fence drains write combining buffers, so the time covers the stores reaching memory
+		auto start = std::chrono::steady_clock::now();
+		WriteBack(*worker.color, color, r);
+		worker.writtenBytes += (uint64_t)r.width * r.height * color.GetElementSize();
+		if (depth && !mDiscardDepth)
+		{
+			WriteBack(*worker.depth, *depth, r);
+			worker.writtenBytes += (uint64_t)r.width * r.height * sizeof(float);
+		}
+		_mm_sfence();
+		worker.writeBackTime += Nanoseconds(start);
+	}
+
+	void TileRenderer::PlaceTargets(Buffer& color, Buffer* depth)
+	{
+		if (!mPool)
+		{
+			return;
+		}
+
+		uint32_t count = mGrid.GetTileCount();
+		mPool->ParallelForNodes(count, [&](uint32_t tile, uint32_t thread)
+		{
+			if (mPool->GetNode(count, tile) != mPool->GetThreadNode(thread))
+			{
+				return;
+			}
+
+			Rect r = mGrid.GetTileRect(tile);
+			for (uint32_t row = r.y; row < r.y + r.height; row++)
+			{
+				size_t first = (size_t)row * mGrid.GetWidth() + r.x;
+				memset((uint8_t*)color.GetData() + first * color.GetElementSize(), 0, (size_t)r.width * color.GetElementSize());
+				if (depth)
+				{
+					memset((uint8_t*)depth->GetData() + first * sizeof(float), 0, (size_t)r.width * sizeof(float));
+				}
+			}
+		});
+	}
+
+	void TileRenderer::PublishNodeStatistics()
+	{
+		// Threads write back concurrently, so a node's bandwidth is the sum of its threads' write back rates
+		uint32_t nodes = (uint32_t)mNodeBandwidth.size();
+		std::fill(mNodeBandwidth.begin(), mNodeBandwidth.end(), 0.0);
+		uint32_t stolen = 0;
+		for (size_t i = 0; i < mWorkers.size(); i++)
+		{
+			const Worker& worker = mWorkers[i];
+			if (worker.writeBackTime)
+			{
+				mNodeBandwidth[mPool ? mPool->GetThreadNode((uint32_t)i) : 0] += (double)worker.writtenBytes / worker.writeBackTime;
+			}
+			stolen += worker.stolenTiles;
+		}
+
+		Profiler& profiler = Profiler::Get();
+		profiler.Set("numa.nodes", (double)nodes);
+		profiler.Set("numa.pinned", mPool && mPool->IsPinned() ? 1.0 : 0.0);
+		profiler.Set("numa.stolenTiles", (double)stolen);
+		for (uint32_t n = 0; n < nodes; n++)
+		{
+			profiler.Set(mNodeKeys[n], mNodeBandwidth[n]);
+		}
+	}
+
+	void TileRenderer::Capture(const std::vector<Vertex>& opaque, const std::vector<Vertex>& transparent, const float4& clearColor,
+		float clearDepth, const Buffer& color)
+	{
+		CaptureState& state = mCapture->state;
+		memset(&state, 0, sizeof(state));
+		state.width = mGrid.GetWidth();
+		state.height = mGrid.GetHeight();
+		state.tileSize = mGrid.GetTileSize();
+		state.colorElementSize = color.GetElementSize();
+		state.topology = (uint32_t)mTopology;
+		state.flags = (mLineAntialiasing ? CaptureState::LineAntialiasing : 0) | (mDiscardDepth ? CaptureState::DiscardDepth : 0);
+		state.transparencyBudget = mFragmentsPerPixel;
+		state.pointSize = mPointSize;
+		for (int i = 0; i < 4; i++)
+		{
+			state.clearColor[i] = clearColor[i];
+		}
+		state.clearDepth = clearDepth;
+
+		mCapture->opaque = opaque;
+		mCapture->transparent = transparent;
+		mCapture = nullptr;
+	}
+
+	void TileRenderer::Render(const std::vector<Vertex>& vertices, const float4& clearColor, float clearDepth, Buffer& color, Buffer* depth,
+		Topology topology)
+	{
+		mTopology = topology;
+		if (mCapture)
+		{
+			Capture(vertices, std::vector<Vertex>(), clearColor, clearDepth, color);
+		}
+
+		// Bins of the previous frame are dead, all arenas are released in one go
+		mArenas.Reset();
+		mTransparentChunks.clear();
+		Bin(vertices, mChunks);
+
+		RenderTiles(clearColor, clearDepth, color, depth);
+	}
+
+	void TileRenderer::Render(const std::vector<Vertex>& opaque, const std::vector<Vertex>& transparent, const float4& clearColor,
+		float clearDepth, Buffer& color, Buffer* depth)
+	{
+		mTopology = Topology::Triangles;
+		if (mCapture)
+		{
+			Capture(opaque, transparent, clearColor, clearDepth, color);
+		}
+
+		mArenas.Reset();
+		Bin(opaque, mChunks);
+		Bin(transparent, mTransparentChunks);
+
+		RenderTiles(clearColor, clearDepth, color, depth);
+	}
+
+	void TileRenderer::RenderTiles(const float4& clearColor, float clearDepth, Buffer& color, Buffer* depth)
+	{
+		uint32_t tileSize = mGrid.GetTileSize();
+
+		// Tile buffers follow target format, they are recreated only when it changes
+		if (mColorElementSize != color.GetElementSize())
+		{
+			mColorElementSize = color.GetElementSize();
+			for (Worker& worker : mWorkers)
+			{
+				worker.color.reset(new Buffer(mColorElementSize, tileSize * tileSize));
+				worker.depth.reset(new Buffer(sizeof(float), tileSize * tileSize));
+				worker.rasterizer.reset(new Rasterizer(worker.color.get(), worker.depth.get(), tileSize, tileSize));
+			}
+		}
+
+		// Fragment pools are sized once per budget, every pixel owns one fragment and shares the rest
+		uint32_t capacity = tileSize * tileSize * (std::max(mFragmentsPerPixel, 1u) - 1);
+		bool transparent = !mTransparentChunks.empty();
+		for (Worker& worker : mWorkers)
+		{
+			if (transparent && (!worker.fragments || worker.fragments->GetCapacity() != capacity))
+			{
+				worker.fragments.reset(new FragmentBuffer(tileSize, tileSize, capacity));
+			}
+			if (worker.fragments)
+			{
+				worker.fragments->ResetStatistics();
+			}
+		}
+
+		for (Worker& worker : mWorkers)
+		{
+			worker.rasterizer->ResetStatistics();
+			worker.rasterizer->SetLineAntialiasing(mLineAntialiasing);
+			worker.rasterizer->SetPointSize(mPointSize);
+			worker.writtenBytes = 0;
+			worker.writeBackTime = 0;
+			worker.stolenTiles = 0;
+		}
+
+		uint32_t packedClear = PackColor(clearColor);
+		const void* clear = mColorElementSize == sizeof(float4) ? (const void*)&clearColor : (const void*)&packedClear;
+
+		auto task = [&](uint32_t tile, uint32_t thread)
+		{
+			RenderTile(tile, mWorkers[thread], clear, clearDepth, color, depth);
+		};
+
+		if (mPool)
+		{
+			mPool->ParallelForNodes(mGrid.GetTileCount(), std::ref(task));
+		}
+		else
+		{
+			for (uint32_t i = 0; i < mGrid.GetTileCount(); i++)
+			{
+				task(i, 0);
+			}
+		}
+		_mm_sfence();
+		PublishNodeStatistics();
+
+		// Compare against immediate mode: clearing both targets, then depth read + write and color write per
+		// fragment, versus a single color (and optional depth) write per pixel
+		Rasterizer::Statistics statistics;
+		memset(&statistics, 0, sizeof(statistics));
+		for (Worker& worker : mWorkers)
+		{
+			const Rasterizer::Statistics& s = worker.rasterizer->GetStatistics();
+			statistics.submitted += s.submitted;
+			statistics.degenerate += s.degenerate;
+			statistics.culled += s.culled;
+			statistics.small += s.small;
+			statistics.large += s.large;
+			statistics.lines += s.lines;
+			statistics.points += s.points;
+			statistics.pixels += s.pixels;
+		}
+		Rasterizer::PublishStatistics(statistics);
+
+		double pixels = (double)mGrid.GetWidth() * mGrid.GetHeight();
+		double immediate = pixels * (mColorElementSize + sizeof(float)) + statistics.pixels * (2.0 * sizeof(float) + mColorElementSize);
+		double tiled = pixels * (mColorElementSize + ((depth && !mDiscardDepth) ? sizeof(float) : 0));
+
+		size_t binned = 0;
+		for (const ChunkBins& bins : mChunks)
+		{
+			binned += bins.offsets[mGrid.GetTileCount()];
+		}
+
+		Profiler::Get().Set("tiles.binnedPrimitives", (double)binned);
+
+		if (transparent)
+		{
+			FragmentBuffer::Statistics fragments;
+			memset(&fragments, 0, sizeof(fragments));
+			size_t poolBytes = 0;
+			for (Worker& worker : mWorkers)
+			{
+				const FragmentBuffer::Statistics& s = worker.fragments->GetStatistics();
+				fragments.fragments += s.fragments;
+				fragments.merged += s.merged;
+				fragments.peak = std::max(fragments.peak, s.peak);
+				poolBytes += worker.fragments->GetBytes();
+			}
+
+			Profiler& profiler = Profiler::Get();
+			profiler.Set("oit.fragments", (double)fragments.fragments);
+			profiler.Set("oit.merged", (double)fragments.merged);
+			profiler.Set("oit.peakFragments", (double)fragments.peak);
+			profiler.Set("oit.poolBytes", (double)poolBytes);
+		}
+		mArenas.Publish("arena");
+		Profiler::Get().Set("tiles.dramBytesSaved", immediate - tiled);
+	}
+}
\ No newline at end of file
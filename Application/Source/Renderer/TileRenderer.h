@@ -0,0 +1,237 @@
+#pragma once
+
+#include "Buffer.h"
+#include "FragmentBuffer.h"
+#include "FrameCapture.h"
+#include "LinearArena.h"
+#include "MpmcQueue.h"
+#include "Rasterizer.h"
+#include "ThreadPool.h"
+#include "TileGrid.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class TileRenderer
+	 * @brief Sort-middle renderer, primitives are binned to screen tiles and every tile is rendered at once.
+	 *
+	 * Each worker rasterizes a whole tile into its own tile sized color and depth buffers (64x64 tiles are 16 kB
+	 * of depth plus 16 kB RGBA8 or 64 kB HDR color, so they stay in L1/L2). Clear, depth test and writes never
+	 * touch the frame buffer, the finished tile is written back once with streaming stores. Depth can be
+	 * discarded, then it never leaves the tile buffer at all.
+	 *
+	 * Binning runs in parallel over contiguous chunks of the primitive list. Lines and points are binned like
+	 * triangles, by bounding box padded with the pixels they may touch past their vertices. Bins are frame lifetime data and
+	 * live in per-thread LinearArenas, reset at the start of each frame. Profiler keys are built once, so steady
+	 * state frames do no heap allocation at all (--benchmark tiles counts operator new calls per frame).
+	 *
+	 * Transparent triangles are binned separately and rendered after the opaque ones of the same tile into a
+	 * per-worker FragmentBuffer with a fixed pool, then sorted and composited before write back. No global sort
+	 * is needed, intersecting triangles resolve per pixel and memory is bounded by the pool size per worker.
+	 *
+	 * Geometry may also be streamed: between BeginFrame and EndFrame any number of producer threads Submit
+	 * triangle batches through a lock-free queue to a binner thread, which bins batch k while producers are
+	 * still transforming batch k + 1. Batches are rendered in order of their sequence numbers, not arrival.
+	 * The binner on an empty queue and producers on a full one spin briefly, then sleep until woken.
+	 *
+	 * With a pinned pool spanning several NUMA nodes every node owns a contiguous band of tiles
+	 * (ThreadPool::ParallelForNodes), its threads render those first. PlaceTargets moves the matching parts of
+	 * the targets to that node's memory, so write back stays local.
+	 */
+	class TileRenderer
+	{
+	public:
+		enum class Topology
+		{
+			Triangles,
+			Lines,
+			Points
+		};
+
+	protected:
+		struct Worker
+		{
+			std::unique_ptr<Buffer> color;
+			std::unique_ptr<Buffer> depth;
+			std::unique_ptr<Rasterizer> rasterizer;
+			std::unique_ptr<FragmentBuffer> fragments;
+			// Frame counters, bytes written to targets, nanoseconds spent writing them and tiles taken from another node
+			uint64_t writtenBytes;
+			uint64_t writeBackTime;
+			uint32_t stolenTiles;
+		};
+
+		/**
+		 * @brief Bins of one chunk of primitives, first vertex indices of tile t are primitives[offsets[t], offsets[t + 1]).
+		 */
+		struct ChunkBins
+		{
+			const Vertex* vertices;
+			uint32_t sequence;
+			uint32_t* offsets;
+			uint32_t* primitives;
+		};
+
+		/**
+		 * @brief Tile range overlapped by a primitive bounding box, empty when x0 > x1.
+		 */
+		struct TileRange
+		{
+			uint16_t x0;
+			uint16_t y0;
+			uint16_t x1;
+			uint16_t y1;
+		};
+
+		struct Batch
+		{
+			const Vertex* vertices;
+			uint32_t vertexCount;
+			uint32_t sequence;
+		};
+
+		TileGrid mGrid;
+		ThreadPool* mPool;
+		bool mDiscardDepth;
+		Topology mTopology;
+		bool mLineAntialiasing;
+		float mPointSize;
+
+		std::vector<ChunkBins> mChunks;
+		std::vector<ChunkBins> mTransparentChunks;
+		uint32_t mFragmentsPerPixel;
+		FrameCapture* mCapture;
+		std::vector<Worker> mWorkers;
+		FrameArenas mArenas;
+		uint32_t mColorElementSize;
+		// Per NUMA node profiler keys and write back bandwidth, sized once so publishing does not allocate
+		std::vector<std::string> mNodeKeys;
+		std::vector<double> mNodeBandwidth;
+
+		// Streaming submission, binner thread is started by first BeginFrame
+		MpmcQueue<Batch> mQueue;
+		LinearArena mBinnerArena;
+		std::thread mBinner;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+		bool mFrameActive;
+		bool mExit;
+		std::atomic<bool> mClosed;
+		// Binner sleeping on an empty queue and producers sleeping on a full one, after a short spin
+		std::condition_variable mQueueReady;
+		std::condition_variable mQueueSpace;
+		std::atomic<bool> mBinnerSleeping;
+		std::atomic<uint32_t> mProducersSleeping;
+
+		std::atomic<uint64_t> mProducerStall;
+		uint64_t mBinnerStall;
+		std::atomic<uint64_t> mDepthSum;
+		std::atomic<uint32_t> mDepthMax;
+		std::atomic<uint32_t> mBatches;
+
+		void Bin(const std::vector<Vertex>& vertices, std::vector<ChunkBins>& chunks);
+		void BinPrimitives(ChunkBins& bins, LinearArena& arena, const Vertex* vertices, uint32_t primitiveCount);
+		void BinnerLoop();
+		void WakeProducers();
+		void Capture(const std::vector<Vertex>& opaque, const std::vector<Vertex>& transparent, const Math::Numeric::float4& clearColor,
+			float clearDepth, const Buffer& color);
+		void RenderTiles(const Math::Numeric::float4& clearColor, float clearDepth, Buffer& color, Buffer* depth);
+		void RenderTile(uint32_t tile, Worker& worker, const void* clearColor, float clearDepth, Buffer& color, Buffer* depth);
+		void WriteBack(const Buffer& source, Buffer& destination, const Rect& rect);
+		void PublishNodeStatistics();
+
+	public:
+		/**
+		 * @param pool Pool rendering tiles in parallel, null renders on calling thread.
+		 * @param queueCapacity Batches in flight between producers and binner before Submit stalls.
+		 */
+		TileRenderer(uint32_t width, uint32_t height, ThreadPool* pool, uint32_t tileSize = 64, uint32_t queueCapacity = 64);
+		virtual ~TileRenderer();
+
+		/**
+		 * @brief When set (default) depth lives only in tile buffers and depth target is never written.
+		 */
+		void SetDiscardDepth(bool discard) { mDiscardDepth = discard; }
+
+		/**
+		 * @brief See Rasterizer::SetLineAntialiasing.
+		 */
+		void SetLineAntialiasing(bool enabled) { mLineAntialiasing = enabled; }
+
+		/**
+		 * @brief See Rasterizer::SetPointSize.
+		 */
+		void SetPointSize(float size) { mPointSize = size; }
+
+		/**
+		 * @brief Average fragments per pixel of transparency pool (default 4), at most FragmentBuffer::MaxLayers
+		 * per pixel are kept before merging.
+		 */
+		void SetTransparencyBudget(uint32_t fragmentsPerPixel) { mFragmentsPerPixel = fragmentsPerPixel; }
+
+		/**
+		 * @brief Next Render call copies its complete input (state and vertex lists) into capture before rendering.
+		 *
+		 * Streamed frames are not captured. Capture must stay valid until that Render call.
+		 */
+		void CaptureNextFrame(FrameCapture* capture) { mCapture = capture; }
+
+		/**
+		 * @brief Renders triangle, line or point list into color (RGBA8 or float4) and optionally depth target.
+		 *
+		 * Publishes numa.nodes, numa.pinned, numa.stolenTiles and numa.node<n>.writeGBs (target write back
+		 * bandwidth of the threads of node n, timed around write back only).
+		 */
+		void Render(const std::vector<Vertex>& vertices, const Math::Numeric::float4& clearColor, float clearDepth, Buffer& color, Buffer* depth,
+			Topology topology = Topology::Triangles);
+
+		/**
+		 * @brief Renders opaque triangle list, then transparent triangle list (vertex alpha) in any order.
+		 *
+		 * Publishes oit.fragments, oit.merged, oit.peakFragments (most shared pool entries used by one tile) and
+		 * oit.poolBytes (all workers).
+		 */
+		void Render(const std::vector<Vertex>& opaque, const std::vector<Vertex>& transparent, const Math::Numeric::float4& clearColor,
+			float clearDepth, Buffer& color, Buffer* depth);
+
+		/**
+		 * @brief Starts a streamed frame of triangles, Submit may be called from any thread until EndFrame.
+		 */
+		void BeginFrame();
+
+		/**
+		 * @brief Queues triangle list batch for binning, stalls while queue is full.
+		 *
+		 * Vertices must stay valid until EndFrame returns. Sequence numbers define draw order of batches and must
+		 * be unique within the frame.
+		 */
+		void Submit(const Vertex* vertices, uint32_t vertexCount, uint32_t sequence);
+
+		/**
+		 * @brief Waits until all batches are binned, then renders tiles like Render.
+		 *
+		 * All Submit calls must have returned. Publishes queue.batches, queue.depthMax, queue.depthAverage,
+		 * queue.producerStallMs and queue.binnerStallMs.
+		 */
+		void EndFrame(const Math::Numeric::float4& clearColor, float clearDepth, Buffer& color, Buffer* depth);
+
+		/**
+		 * @brief First touch of every tile of the targets from a thread of the node owning it.
+		 *
+		 * Linux places a page on the node of the thread writing it first. Buffers of target size are mapped fresh
+		 * from the OS, so this works for targets nobody wrote yet: call it right after allocating them and after
+		 * ThreadPool::Pin. Tiles stolen by another node are skipped and placed by the first frame instead.
+		 */
+		void PlaceTargets(Buffer& color, Buffer* depth);
+
+		const TileGrid& GetGrid() const { return mGrid; }
+	};
+}
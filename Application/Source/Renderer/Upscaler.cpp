@@ -0,0 +1,149 @@
+#include "Upscaler.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <emmintrin.h>
+
+namespace Renderer
+{
+	namespace
+	{
+		const int WeightBits = 7;
+		const int WeightOne = 1 << WeightBits;
+		const uint32_t RowsPerTask = 16;
+
+		/**
+		 * @brief Maps destination coordinate to left / top source sample and weight of the right / bottom one.
+		 */
+		void SourcePosition(uint32_t destination, uint32_t destinationSize, uint32_t sourceSize, uint32_t& index, uint32_t& weight)
+		{
+			// 16.16 fixed point source coordinate of destination pixel center, relative to source pixel centers
+			int64_t position = (((int64_t)destination * 2 + 1) * sourceSize << 16) / ((int64_t)destinationSize * 2) - (1 << 15);
+			position = std::max<int64_t>(position, 0);
+
+			index = (uint32_t)(position >> 16);
+			weight = (uint32_t)((position & 0xffff) >> (16 - WeightBits));
+
+			// Last sample has no right neighbour, use the pair before it with full weight on the right
+			if (index >= sourceSize - 1)
+			{
+				index = sourceSize - 2;
+				weight = WeightOne;
+			}
+		}
+
+		/**
+		 * @brief Destination range [first, end) sampling source range [sourceFirst, sourceEnd), one pixel border.
+		 */
+		void DestinationRange(uint32_t sourceFirst, uint32_t sourceEnd, uint32_t sourceSize, uint32_t destinationSize, uint32_t& first, uint32_t& end)
+		{
+			// Destination pixel samples source pixels index and index + 1, one extra pixel each side absorbs rounding
+			uint64_t low = sourceFirst > 1 ? (uint64_t)(sourceFirst - 1) * destinationSize / sourceSize : 0;
+			uint64_t high = ((uint64_t)(sourceEnd + 1) * destinationSize + sourceSize - 1) / sourceSize + 1;
+			first = (uint32_t)(low > 0 ? low - 1 : 0);
+			end = (uint32_t)std::min<uint64_t>(high, destinationSize);
+		}
+	}
+
+	Rect Upscaler::GetDestinationRect(const Rect& source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t destinationWidth,
+		uint32_t destinationHeight)
+	{
+		uint32_t x0;
+		uint32_t x1;
+		uint32_t y0;
+		uint32_t y1;
+		DestinationRange(source.x, source.x + source.width, sourceWidth, destinationWidth, x0, x1);
+		DestinationRange(source.y, source.y + source.height, sourceHeight, destinationHeight, y0, y1);
+		Rect rect = { x0, y0, x1 - x0, y1 - y0 };
+		return rect;
+	}
+
+	Upscaler::Upscaler(ThreadPool* pool)
+		: mPool(pool), mSourceWidth(0), mDestinationWidth(0)
+	{
+	}
+
+	void Upscaler::UpscaleRow(const uint8_t* row0, const uint8_t* row1, uint32_t rowWeight, uint32_t* destination, uint32_t x0, uint32_t x1) const
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i round = _mm_set1_epi16(WeightOne / 2);
+		__m128i w1 = _mm_set1_epi16((short)rowWeight);
+		__m128i w0 = _mm_set1_epi16((short)(WeightOne - rowWeight));
+
+		for (uint32_t x = x0; x < x1; x++)
+		{
+			// Pixels x0 and x0 + 1 of both rows, unpacked to 8 x 16 bit
+			uint32_t offset = mColumns[x] * 4;
+			__m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row0 + offset)), zero);
+			__m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row1 + offset)), zero);
+
+			// Vertical then horizontal pass, products stay below 255 * 128 so 16 bit is enough
+			__m128i vertical = _mm_add_epi16(_mm_mullo_epi16(top, w0), _mm_mullo_epi16(bottom, w1));
+			vertical = _mm_srli_epi16(_mm_add_epi16(vertical, round), WeightBits);
+
+			uint16_t columnWeight = mColumnWeights[x];
+			__m128i horizontal = _mm_mullo_epi16(vertical, _mm_set_epi16(columnWeight, columnWeight, columnWeight, columnWeight,
+				WeightOne - columnWeight, WeightOne - columnWeight, WeightOne - columnWeight, WeightOne - columnWeight));
+			horizontal = _mm_add_epi16(horizontal, _mm_srli_si128(horizontal, 8));
+			horizontal = _mm_srli_epi16(_mm_add_epi16(horizontal, round), WeightBits);
+
+			destination[x - x0] = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(horizontal, zero));
+		}
+	}
+
+	void Upscaler::Upscale(const void* source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t sourcePitch,
+		void* destination, uint32_t destinationWidth, uint32_t destinationHeight, uint32_t destinationPitch)
+	{
+		Rect rect = { 0, 0, destinationWidth, destinationHeight };
+		Upscale(source, sourceWidth, sourceHeight, sourcePitch, destination, destinationWidth, destinationHeight, destinationPitch, rect);
+	}
+
+	void Upscaler::Upscale(const void* source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t sourcePitch,
+		void* destination, uint32_t destinationWidth, uint32_t destinationHeight, uint32_t destinationPitch, const Rect& rect)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// Column tables only change with resolution
+		if (mSourceWidth != sourceWidth || mDestinationWidth != destinationWidth)
+		{
+			mSourceWidth = sourceWidth;
+			mDestinationWidth = destinationWidth;
+			mColumns.resize(destinationWidth);
+			mColumnWeights.resize(destinationWidth);
+			for (uint32_t x = 0; x < destinationWidth; x++)
+			{
+				uint32_t weight;
+				SourcePosition(x, destinationWidth, sourceWidth, mColumns[x], weight);
+				mColumnWeights[x] = (uint16_t)weight;
+			}
+		}
+
+		auto task = [&](uint32_t index, uint32_t)
+		{
+			uint32_t end = std::min((index + 1) * RowsPerTask, rect.height);
+			for (uint32_t y = index * RowsPerTask; y < end; y++)
+			{
+				uint32_t row;
+				uint32_t weight;
+				SourcePosition(rect.y + y, destinationHeight, sourceHeight, row, weight);
+				UpscaleRow((const uint8_t*)source + (size_t)row * sourcePitch, (const uint8_t*)source + (size_t)(row + 1) * sourcePitch, weight,
+					(uint32_t*)((uint8_t*)destination + (size_t)y * destinationPitch), rect.x, rect.x + rect.width);
+			}
+		};
+
+		uint32_t tasks = (rect.height + RowsPerTask - 1) / RowsPerTask;
+		if (mPool)
+		{
+			mPool->ParallelFor(tasks, task);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < tasks; i++)
+			{
+				task(i, 0);
+			}
+		}
+
+		Profiler::Get().Set("upscale.ms", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "TileGrid.h"
+#include <cstdint>
+#include <vector>
+
+namespace Renderer
+{
+	/**
+	 * @class Upscaler
+	 * @brief Bilinear RGBA8 resampler for presenting a lower internal resolution at window size.
+	 *
+	 * Source coordinates of every destination column are computed once per size change and kept in tables,
+	 * weights are 7 bit fixed point so both interpolation passes run in SSE2 16 bit arithmetic on both
+	 * neighbouring pixels at once. Rows are split across the thread pool.
+	 */
+	class Upscaler
+	{
+	protected:
+		ThreadPool* mPool;
+
+		uint32_t mSourceWidth;
+		uint32_t mDestinationWidth;
+		std::vector<uint32_t> mColumns;
+		std::vector<uint16_t> mColumnWeights;
+
+		void UpscaleRow(const uint8_t* row0, const uint8_t* row1, uint32_t rowWeight, uint32_t* destination, uint32_t x0, uint32_t x1) const;
+
+	public:
+		/**
+		 * @param pool Pool to split rows across, null processes on calling thread.
+		 */
+		Upscaler(ThreadPool* pool = nullptr);
+
+		/**
+		 * @brief Resamples source image to destination size, pixel centers are aligned (no half pixel shift).
+		 * @param sourcePitch Bytes between source rows, source must be at least 2x2 pixels.
+		 * @param destinationPitch Bytes between destination rows.
+		 */
+		void Upscale(const void* source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t sourcePitch,
+			void* destination, uint32_t destinationWidth, uint32_t destinationHeight, uint32_t destinationPitch);
+
+		/**
+		 * @brief Resamples only rectangle of destination, pixels are identical to a full Upscale.
+		 * @param destination Output for the rectangle, its first pixel is rect.x, rect.y.
+		 */
+		void Upscale(const void* source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t sourcePitch,
+			void* destination, uint32_t destinationWidth, uint32_t destinationHeight, uint32_t destinationPitch, const Rect& rect);
+
+		/**
+		 * @brief Destination rectangle covering every pixel whose bilinear footprint overlaps source rectangle.
+		 */
+		static Rect GetDestinationRect(const Rect& source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t destinationWidth,
+			uint32_t destinationHeight);
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../Math/Numeric/Float4.h"
+
+namespace Renderer
+{
+	/**
+	 * @struct Vertex
+	 * @brief Post-transform vertex as consumed by the rasterizer.
+	 */
+	struct Vertex
+	{
+		/** @brief Screen space position, x and y in pixels, z depth in [0, 1], w unused. */
+		Math::Numeric::float4 position;
+		/** @brief Color, RGBA in [0, 1]. */
+		Math::Numeric::float4 color;
+		/** @brief Texture coordinates (or any other value interpolated for pixel shader). */
+		Math::Numeric::float4 texcoord;
+	};
+}
\ No newline at end of file
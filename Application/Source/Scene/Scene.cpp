@@ -0,0 +1,171 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Scenes
+{
+	using Math::Numeric::float4;
+
+	namespace
+	{
+		Renderer::Vertex MakeVertex(float x, float y, float z, const float4& color, uint32_t width, uint32_t height)
+		{
+			Renderer::Vertex v;
+			v.position = float4(x, y, z, 1.0f);
+			v.color = color;
+			v.texcoord = float4(x / width, y / height, 0.0f, 0.0f);
+			return v;
+		}
+
+		uint64_t PositionKey(const Renderer::Vertex& v)
+		{
+			uint32_t x;
+			uint32_t y;
+			memcpy(&x, &v.position.x, sizeof(x));
+			memcpy(&y, &v.position.y, sizeof(y));
+			return ((uint64_t)x << 32) | y;
+		}
+
+		struct Edge
+		{
+			uint64_t a;
+			uint64_t b;
+			uint32_t first;
+			uint32_t second;
+		};
+	}
+
+	void CreateMicroTriangles(Scene& scene, uint32_t width, uint32_t height, float size, uint32_t seed)
+	{
+		Random random(seed);
+
+		scene.clearColor = float4(0.0f, 0.0f, 0.0f, 1.0f);
+		scene.clearDepth = 1.0f;
+		scene.vertices.clear();
+
+		// Jittered grid, two triangles per cell, like a finely tessellated surface
+		uint32_t columns = (uint32_t)(width / size);
+		uint32_t rows = (uint32_t)(height / size);
+		std::vector<Renderer::Vertex> grid((columns + 1) * (rows + 1));
+		for (uint32_t y = 0; y <= rows; y++)
+		{
+			for (uint32_t x = 0; x <= columns; x++)
+			{
+				float jitterX = (x > 0 && x < columns) ? (random.NextFloat() - 0.5f) * size * 0.5f : 0.0f;
+				float jitterY = (y > 0 && y < rows) ? (random.NextFloat() - 0.5f) * size * 0.5f : 0.0f;
+				float4 color(random.NextFloat(), random.NextFloat(), random.NextFloat(), 1.0f);
+				grid[y * (columns + 1) + x] = MakeVertex(x * size + jitterX, y * size + jitterY, 0.5f + random.NextFloat() * 0.25f, color, width, height);
+			}
+		}
+
+		scene.vertices.reserve(columns * rows * 6);
+		for (uint32_t y = 0; y < rows; y++)
+		{
+			for (uint32_t x = 0; x < columns; x++)
+			{
+				const Renderer::Vertex& v00 = grid[y * (columns + 1) + x];
+				const Renderer::Vertex& v10 = grid[y * (columns + 1) + x + 1];
+				const Renderer::Vertex& v01 = grid[(y + 1) * (columns + 1) + x];
+				const Renderer::Vertex& v11 = grid[(y + 1) * (columns + 1) + x + 1];
+
+				scene.vertices.push_back(v00);
+				scene.vertices.push_back(v10);
+				scene.vertices.push_back(v01);
+				scene.vertices.push_back(v10);
+				scene.vertices.push_back(v11);
+				scene.vertices.push_back(v01);
+			}
+		}
+	}
+
+	void CreateRandomTriangles(Scene& scene, uint32_t width, uint32_t height, uint32_t count, uint32_t seed)
+	{
+		Random random(seed);
+
+		scene.clearColor = float4(0.125f, 0.125f, 0.125f, 1.0f);
+		scene.clearDepth = 1.0f;
+		scene.vertices.clear();
+		scene.vertices.reserve(count * 3);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				float4 color(random.NextFloat(), random.NextFloat(), random.NextFloat(), 1.0f);
+				scene.vertices.push_back(MakeVertex(random.NextFloat() * width, random.NextFloat() * height, random.NextFloat(), color, width, height));
+			}
+		}
+	}
+
+	void CreateTransparentTriangles(Scene& scene, uint32_t width, uint32_t height, uint32_t count, uint32_t seed)
+	{
+		CreateRandomTriangles(scene, width, height, count, seed);
+
+		// Flat alpha per triangle so every triangle reads as one sheet
+		Random random(seed + 1);
+		for (size_t i = 0; i + 2 < scene.vertices.size(); i += 3)
+		{
+			float alpha = 0.25f + random.NextFloat() * 0.5f;
+			for (size_t j = i; j < i + 3; j++)
+			{
+				scene.vertices[j].color.w = alpha;
+			}
+		}
+	}
+
+	void CreateWireframe(const Scene& source, Scene& wireframe)
+	{
+		wireframe.clearColor = source.clearColor;
+		wireframe.clearDepth = source.clearDepth;
+		wireframe.vertices.clear();
+
+		// Edges are keyed by endpoint positions in canonical order, then sorted so shared ones end up adjacent
+		std::vector<Edge> edges;
+		edges.reserve(source.vertices.size());
+		for (uint32_t t = 0; t + 2 < (uint32_t)source.vertices.size(); t += 3)
+		{
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				uint32_t first = t + i;
+				uint32_t second = t + (i + 1) % 3;
+				uint64_t a = PositionKey(source.vertices[first]);
+				uint64_t b = PositionKey(source.vertices[second]);
+				Edge edge = { std::min(a, b), std::max(a, b), first, second };
+				edges.push_back(edge);
+			}
+		}
+
+		std::sort(edges.begin(), edges.end(), [](const Edge& l, const Edge& r)
+		{
+			return l.a != r.a ? l.a < r.a : (l.b != r.b ? l.b < r.b : l.first < r.first);
+		});
+		edges.erase(std::unique(edges.begin(), edges.end(), [](const Edge& l, const Edge& r) { return l.a == r.a && l.b == r.b; }), edges.end());
+
+		// Back to submission order of the first triangle using each edge
+		std::sort(edges.begin(), edges.end(), [](const Edge& l, const Edge& r) { return l.first < r.first; });
+
+		wireframe.vertices.reserve(edges.size() * 2);
+		for (const Edge& edge : edges)
+		{
+			wireframe.vertices.push_back(source.vertices[edge.first]);
+			wireframe.vertices.push_back(source.vertices[edge.second]);
+		}
+	}
+
+	bool Create(const std::string& name, uint32_t width, uint32_t height, Scene& scene)
+	{
+		if (name == "micro")
+		{
+			CreateMicroTriangles(scene, width, height, 2.0f, 1);
+			return true;
+		}
+
+		if (name == "triangles")
+		{
+			CreateRandomTriangles(scene, width, height, 64, 1);
+			return true;
+		}
+
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../Renderer/Vertex.h"
+#include <string>
+#include <vector>
+
+namespace Scenes
+{
+	/**
+	 * @struct Scene
+	 * @brief Screen space triangle list with clear values, procedurally generated for a given resolution.
+	 */
+	struct Scene
+	{
+		Math::Numeric::float4 clearColor;
+		float clearDepth;
+		/** @brief Triangle list, every 3 vertices form a triangle. */
+		std::vector<Renderer::Vertex> vertices;
+	};
+
+	/**
+	 * @brief Small deterministic generator, results must not depend on the platform C runtime.
+	 */
+	class Random
+	{
+	protected:
+		uint32_t mState;
+
+	public:
+		Random(uint32_t seed) : mState(seed * 747796405u + 2891336453u) {}
+
+		uint32_t Next()
+		{
+			mState = mState * 1664525u + 1013904223u;
+			uint32_t x = mState;
+			x ^= x >> 16;
+			x *= 0x7feb352du;
+			x ^= x >> 15;
+			return x;
+		}
+
+		/** @brief Uniform float in [0, 1). */
+		float NextFloat() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+	};
+
+	/**
+	 * @brief Surface tessellated into triangles covering a handful of pixels each (high-poly mesh seen from afar).
+	 * @param size Grid cell size in pixels, every cell holds 2 triangles.
+	 */
+	void CreateMicroTriangles(Scene& scene, uint32_t width, uint32_t height, float size, uint32_t seed);
+
+	/**
+	 * @brief Overlapping triangles of random size, depth and color.
+	 */
+	void CreateRandomTriangles(Scene& scene, uint32_t width, uint32_t height, uint32_t count, uint32_t seed);
+
+	/**
+	 * @brief Overlapping triangles of random size, depth and color with alpha in [0.25, 0.75), drawn in no
+	 * particular depth order.
+	 */
+	void CreateTransparentTriangles(Scene& scene, uint32_t width, uint32_t height, uint32_t count, uint32_t seed);
+
+	/**
+	 * @brief Line list of unique triangle edges of source scene (edges shared by triangles are emitted once).
+	 */
+	void CreateWireframe(const Scene& source, Scene& wireframe);
+
+	/**
+	 * @brief Creates scene by name ("micro", "triangles").
+	 * @return False if name is unknown.
+	 */
+	bool Create(const std::string& name, uint32_t width, uint32_t height, Scene& scene);
+}
\ No newline at end of file
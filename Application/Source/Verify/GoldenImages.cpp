@@ -0,0 +1,576 @@
+#include "GoldenImages.h"
+#include "../Export/Encoders.h"
+#include "../Renderer/Color.h"
+#include "../Renderer/MultisampleBuffer.h"
+#include "../Renderer/OutputStage.h"
+#include "../Renderer/Rasterizer.h"
+#include "../Renderer/ShadowMap.h"
+#include "../Renderer/ThreadPool.h"
+#include "../Renderer/TileRenderer.h"
+#include "../Scene/Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace Verify
+{
+	namespace
+	{
+		const uint32_t Width = 320;
+		const uint32_t Height = 240;
+		const float PerceptualThreshold = 3.0f;
+
+		typedef std::vector<uint32_t> Image;
+
+		void CopyImage(const Renderer::Buffer& buffer, Image& image)
+		{
+			image.resize(Width * Height);
+			memcpy(image.data(), buffer.GetData(), image.size() * sizeof(uint32_t));
+		}
+
+		void RenderImmediate(const char* sceneName, bool smallPath, Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create(sceneName, Width, Height, scene);
+
+			Renderer::Buffer color(4, Width * Height);
+			Renderer::Buffer depth(4, Width * Height);
+			uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+			color.Fill(&clearColor);
+			depth.Fill(&scene.clearDepth);
+
+			Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+			rasterizer.SetSmallTrianglePath(smallPath);
+			for (size_t i = 0; i + 2 < scene.vertices.size(); i += 3)
+			{
+				rasterizer.DrawTriangle(scene.vertices[i], scene.vertices[i + 1], scene.vertices[i + 2]);
+			}
+			CopyImage(color, image);
+		}
+
+		void RenderTiled(const char* sceneName, uint32_t threads, Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create(sceneName, Width, Height, scene);
+
+			Renderer::ThreadPool pool(threads);
+			Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+			Renderer::Buffer color(4, Width * Height);
+			tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, color, nullptr);
+			CopyImage(color, image);
+		}
+
+		void RenderStreamed(const char* sceneName, uint32_t producerCount, Image& image)
+		{
+			const uint32_t batchTriangles = 64;
+
+			Scenes::Scene scene;
+			Scenes::Create(sceneName, Width, Height, scene);
+
+			Renderer::ThreadPool pool(2);
+			Renderer::ThreadPool producers(producerCount);
+			Renderer::TileRenderer tileRenderer(Width, Height, &pool, 64, 4);
+			Renderer::Buffer color(4, Width * Height);
+
+			uint32_t triangleCount = (uint32_t)(scene.vertices.size() / 3);
+			uint32_t batchCount = (triangleCount + batchTriangles - 1) / batchTriangles;
+			tileRenderer.BeginFrame();
+			producers.ParallelFor(batchCount, [&](uint32_t batch, uint32_t)
+			{
+				uint32_t first = batch * batchTriangles;
+				uint32_t count = std::min(batchTriangles, triangleCount - first);
+				tileRenderer.Submit(&scene.vertices[first * 3], count * 3, batch);
+			});
+			tileRenderer.EndFrame(scene.clearColor, scene.clearDepth, color, nullptr);
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief Wireframe of random triangles, immediately when threads is 0, otherwise through tile renderer.
+		 */
+		void RenderWireframe(bool antialiased, uint32_t threads, Image& image)
+		{
+			Scenes::Scene filled;
+			Scenes::Create("triangles", Width, Height, filled);
+			Scenes::Scene scene;
+			Scenes::CreateWireframe(filled, scene);
+
+			Renderer::Buffer color(4, Width * Height);
+			if (threads)
+			{
+				Renderer::ThreadPool pool(threads);
+				Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+				tileRenderer.SetLineAntialiasing(antialiased);
+				tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, color, nullptr, Renderer::TileRenderer::Topology::Lines);
+				CopyImage(color, image);
+				return;
+			}
+
+			Renderer::Buffer depth(4, Width * Height);
+			uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+			color.Fill(&clearColor);
+			depth.Fill(&scene.clearDepth);
+
+			Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+			rasterizer.SetLineAntialiasing(antialiased);
+			for (size_t i = 0; i + 1 < scene.vertices.size(); i += 2)
+			{
+				rasterizer.DrawLine(scene.vertices[i], scene.vertices[i + 1]);
+			}
+			CopyImage(color, image);
+		}
+
+		void RenderPoints(uint32_t threads, Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create("triangles", Width, Height, scene);
+
+			Renderer::ThreadPool pool(threads);
+			Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+			Renderer::Buffer color(4, Width * Height);
+			tileRenderer.SetPointSize(5.0f);
+			tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, color, nullptr, Renderer::TileRenderer::Topology::Points);
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief Transparent triangles over opaque ones, full frame k-buffer when threads is 0, otherwise tiles.
+		 */
+		void RenderTransparent(uint32_t threads, Image& image)
+		{
+			Scenes::Scene opaque;
+			Scenes::Create("triangles", Width, Height, opaque);
+			Scenes::Scene transparent;
+			Scenes::CreateTransparentTriangles(transparent, Width, Height, 32, 2);
+
+			Renderer::Buffer color(4, Width * Height);
+			if (threads)
+			{
+				Renderer::ThreadPool pool(threads);
+				Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+				tileRenderer.SetTransparencyBudget(Renderer::FragmentBuffer::MaxLayers);
+				tileRenderer.Render(opaque.vertices, transparent.vertices, opaque.clearColor, opaque.clearDepth, color, nullptr);
+				CopyImage(color, image);
+				return;
+			}
+
+			Renderer::Buffer depth(4, Width * Height);
+			uint32_t clearColor = Renderer::PackColor(opaque.clearColor);
+			color.Fill(&clearColor);
+			depth.Fill(&opaque.clearDepth);
+
+			Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+			for (size_t i = 0; i + 2 < opaque.vertices.size(); i += 3)
+			{
+				rasterizer.DrawTriangle(opaque.vertices[i], opaque.vertices[i + 1], opaque.vertices[i + 2]);
+			}
+
+			Renderer::FragmentBuffer fragments(Width, Height, Width * Height * (Renderer::FragmentBuffer::MaxLayers - 1));
+			rasterizer.SetFragmentBuffer(&fragments);
+			for (size_t i = 0; i + 2 < transparent.vertices.size(); i += 3)
+			{
+				rasterizer.DrawTriangle(transparent.vertices[i], transparent.vertices[i + 1], transparent.vertices[i + 2]);
+			}
+			fragments.Resolve(color);
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief More overlapping half transparent rectangles than a pixel keeps layers, every layer nearer than the
+		 * previous one when backToFront is set, farther otherwise.
+		 */
+		void RenderLayers(bool backToFront, Image& image)
+		{
+			const int Layers = Renderer::FragmentBuffer::MaxLayers + 4;
+
+			Renderer::Buffer color(4, Width * Height);
+			uint32_t clearColor = 0xff202020;
+			color.Fill(&clearColor);
+
+			std::vector<Renderer::Vertex> vertices;
+			for (int i = 0; i < Layers; i++)
+			{
+				int layer = backToFront ? Layers - 1 - i : i;
+				float left = 8.0f + layer * 10.0f;
+				float top = 6.0f + layer * 8.0f;
+				float right = Width - 8.0f - (Layers - 1 - layer) * 6.0f;
+				float bottom = Height - 6.0f - (Layers - 1 - layer) * 4.0f;
+
+				Renderer::Vertex corners[4];
+				for (int c = 0; c < 4; c++)
+				{
+					corners[c].position = Math::Numeric::float4(c & 1 ? right : left, c & 2 ? bottom : top, 0.1f + layer * 0.05f, 1.0f);
+					corners[c].color = Math::Numeric::float4((layer % 3) * 0.5f, ((layer + 1) % 4) * 0.33f, ((layer + 2) % 5) * 0.25f, 0.5f);
+				}
+				vertices.insert(vertices.end(), { corners[0], corners[1], corners[2], corners[1], corners[3], corners[2] });
+			}
+
+			Renderer::Rasterizer rasterizer(&color, nullptr, Width, Height);
+			Renderer::FragmentBuffer fragments(Width, Height, Width * Height * (Renderer::FragmentBuffer::MaxLayers - 1));
+			rasterizer.SetFragmentBuffer(&fragments);
+			for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+			{
+				rasterizer.DrawTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+			}
+			fragments.Resolve(color);
+			CopyImage(color, image);
+		}
+
+		void RenderHDR(uint32_t threads, Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create("triangles", Width, Height, scene);
+
+			// Push colors above 1 so the tonemapper has a range to compress
+			for (Renderer::Vertex& v : scene.vertices)
+			{
+				v.color = v.color * 4.0f;
+			}
+
+			Renderer::ThreadPool pool(threads);
+			Renderer::TileRenderer tileRenderer(Width, Height, &pool);
+			Renderer::OutputStage output(&pool);
+			output.SetTonemap(Renderer::Tonemap::ACES);
+			output.SetDither(true);
+
+			Renderer::Buffer hdr(16, Width * Height);
+			tileRenderer.Render(scene.vertices, scene.clearColor, scene.clearDepth, hdr, nullptr);
+
+			image.resize(Width * Height);
+			Renderer::Rect rect = { 0, 0, Width, Height };
+			output.Process(hdr, Width, rect, image.data(), Width * 4);
+		}
+
+		void RenderShadows(Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create("triangles", Width, Height, scene);
+
+			Renderer::ShadowMap shadowMap(512);
+			shadowMap.SetLight(0.6f, -0.5f, Width, Height, 100.0f);
+			shadowMap.Render(scene.vertices);
+
+			Renderer::Buffer color(4, Width * Height);
+			Renderer::Buffer depth(4, Width * Height);
+			uint32_t clearColor = Renderer::PackColor(scene.clearColor);
+			color.Fill(&clearColor);
+			depth.Fill(&scene.clearDepth);
+
+			Renderer::Rasterizer rasterizer(&color, &depth, Width, Height);
+			Renderer::ShadowShader shader(shadowMap);
+			for (size_t i = 0; i + 2 < scene.vertices.size(); i += 3)
+			{
+				rasterizer.DrawTriangle(scene.vertices[i], scene.vertices[i + 1], scene.vertices[i + 2], shader);
+			}
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief Overlapping disks with coverage evaluated at sample positions, exercises compressed and expanded tiles.
+		 */
+		void RenderMultisample(uint32_t samples, uint32_t tileSize, Image& image)
+		{
+			Renderer::MultisampleBuffer target(Width, Height, samples, tileSize);
+			target.Clear(0xff202020, 1.0f);
+
+			const float* positions = Renderer::MultisampleBuffer::GetSamplePositions(samples);
+			Scenes::Random random(7);
+			float depth[16];
+			for (int disk = 0; disk < 48; disk++)
+			{
+				float cx = random.NextFloat() * Width;
+				float cy = random.NextFloat() * Height;
+				float radius = 4.0f + random.NextFloat() * 40.0f;
+				float z = random.NextFloat();
+				uint32_t color = 0xff000000 | (random.Next() & 0xffffff);
+				for (uint32_t s = 0; s < samples; s++)
+				{
+					depth[s] = z;
+				}
+
+				int x0 = std::max((int)(cx - radius) - 1, 0);
+				int y0 = std::max((int)(cy - radius) - 1, 0);
+				int x1 = std::min((int)(cx + radius) + 1, (int)Width - 1);
+				int y1 = std::min((int)(cy + radius) + 1, (int)Height - 1);
+				for (int y = y0; y <= y1; y++)
+				{
+					for (int x = x0; x <= x1; x++)
+					{
+						uint32_t coverage = 0;
+						for (uint32_t s = 0; s < samples; s++)
+						{
+							float dx = x + 0.5f + positions[s * 2] - cx;
+							float dy = y + 0.5f + positions[s * 2 + 1] - cy;
+							coverage |= (dx * dx + dy * dy <= radius * radius) ? 1u << s : 0u;
+						}
+						if (coverage)
+						{
+							target.Write(x, y, coverage, depth, color);
+						}
+					}
+				}
+			}
+
+			Renderer::Buffer color(4, Width * Height);
+			target.Resolve(color);
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief Scene rasterized into a multisampled target, 1x has its only sample at the pixel center.
+		 */
+		void RenderMultisampleScene(const char* sceneName, uint32_t samples, Image& image)
+		{
+			Scenes::Scene scene;
+			Scenes::Create(sceneName, Width, Height, scene);
+
+			Renderer::MultisampleBuffer target(Width, Height, samples);
+			target.Clear(Renderer::PackColor(scene.clearColor), scene.clearDepth);
+
+			Renderer::Rasterizer rasterizer(nullptr, nullptr, Width, Height);
+			rasterizer.SetMultisampleBuffer(&target);
+			rasterizer.DrawTriangles(scene.vertices.data(), nullptr, (uint32_t)(scene.vertices.size() / 3));
+
+			Renderer::Buffer color(4, Width * Height);
+			target.Resolve(color);
+			CopyImage(color, image);
+		}
+
+		/**
+		 * @brief Wireframe of random triangles in a multisampled target without color target, or 5 pixel points at
+		 * the triangle vertices when points is set.
+		 */
+		void RenderMultisampleLines(bool points, bool antialiased, uint32_t samples, Image& image)
+		{
+			Scenes::Scene filled;
+			Scenes::Create("triangles", Width, Height, filled);
+			Scenes::Scene scene;
+			Scenes::CreateWireframe(filled, scene);
+
+			Renderer::MultisampleBuffer target(Width, Height, samples);
+			target.Clear(Renderer::PackColor(scene.clearColor), scene.clearDepth);
+
+			Renderer::Rasterizer rasterizer(nullptr, nullptr, Width, Height);
+			rasterizer.SetMultisampleBuffer(&target);
+			rasterizer.SetLineAntialiasing(antialiased);
+			rasterizer.SetPointSize(5.0f);
+			if (points)
+			{
+				for (const Renderer::Vertex& v : filled.vertices)
+				{
+					rasterizer.DrawPoint(v);
+				}
+			}
+			else
+			{
+				rasterizer.DrawLines(scene.vertices.data(), nullptr, (uint32_t)(scene.vertices.size() / 2));
+			}
+
+			Renderer::Buffer color(4, Width * Height);
+			target.Resolve(color);
+			CopyImage(color, image);
+		}
+
+		struct Case
+		{
+			const char* name;
+			/** @brief Case this one must match exactly, null for cases checked against a golden image. */
+			const char* reference;
+			std::function<void(Image&)> render;
+		};
+	}
+
+	ImageDiff Compare(const uint32_t* image, const uint32_t* reference, uint32_t width, uint32_t height, float threshold, std::vector<uint32_t>* diffImage)
+	{
+		ImageDiff diff;
+		diff.differing = 0;
+		diff.perceptible = 0;
+		diff.maxError = 0;
+		double squaredError = 0.0;
+
+		size_t count = (size_t)width * height;
+		if (diffImage)
+		{
+			diffImage->resize(count);
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			int dr = (int)(image[i] & 0xff) - (int)(reference[i] & 0xff);
+			int dg = (int)((image[i] >> 8) & 0xff) - (int)((reference[i] >> 8) & 0xff);
+			int db = (int)((image[i] >> 16) & 0xff) - (int)((reference[i] >> 16) & 0xff);
+			int error = std::max(std::abs(dr), std::max(std::abs(dg), std::abs(db)));
+
+			squaredError += dr * dr + dg * dg + db * db;
+			diff.maxError = std::max(diff.maxError, (uint32_t)error);
+
+			float dy = 0.299f * dr + 0.587f * dg + 0.114f * db;
+			float dcb = -0.169f * dr - 0.331f * dg + 0.5f * db;
+			float dcr = 0.5f * dr - 0.419f * dg - 0.081f * db;
+			float perceptual = sqrtf(dy * dy + 0.25f * (dcb * dcb + dcr * dcr));
+
+			diff.differing += error > 0 ? 1 : 0;
+			diff.perceptible += perceptual > threshold ? 1 : 0;
+
+			if (diffImage)
+			{
+				uint32_t dimmed = (reference[i] >> 2) & 0x003f3f3f;
+				uint32_t red = std::min(128 + error * 8, 255);
+				(*diffImage)[i] = 0xff000000 | (error > 0 ? red : dimmed);
+			}
+		}
+
+		double mse = squaredError / (count * 3.0);
+		diff.psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+		return diff;
+	}
+
+	bool LoadPPM(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+		{
+			return false;
+		}
+
+		unsigned w = 0;
+		unsigned h = 0;
+		unsigned maximum = 0;
+		bool loaded = fscanf(file, "P6 %u %u %u", &w, &h, &maximum) == 3 && maximum == 255 && fgetc(file) != EOF;
+		if (loaded)
+		{
+			std::vector<uint8_t> rgb((size_t)w * h * 3);
+			loaded = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+			pixels.resize((size_t)w * h);
+			for (size_t i = 0; loaded && i < pixels.size(); i++)
+			{
+				pixels[i] = 0xff000000 | rgb[i * 3] | (rgb[i * 3 + 1] << 8) | (rgb[i * 3 + 2] << 16);
+			}
+			width = w;
+			height = h;
+		}
+
+		fclose(file);
+		return loaded;
+	}
+
+	bool SavePPM(const std::string& path, const uint32_t* pixels, uint32_t width, uint32_t height)
+	{
+		std::vector<uint8_t> encoded;
+		Export::EncodePPM(pixels, width, height, encoded);
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+		bool written = fwrite(encoded.data(), 1, encoded.size(), file) == encoded.size();
+		return fclose(file) == 0 && written;
+	}
+
+	uint32_t RunGoldenTests(const std::string& directory, bool update, std::ostream& output)
+	{
+		const Case cases[] =
+		{
+			{ "raster-triangles", nullptr, [](Image& image) { RenderImmediate("triangles", true, image); } },
+			{ "raster-micro", nullptr, [](Image& image) { RenderImmediate("micro", true, image); } },
+			{ "raster-micro-general", "raster-micro", [](Image& image) { RenderImmediate("micro", false, image); } },
+			{ "tiled-triangles-1", "raster-triangles", [](Image& image) { RenderTiled("triangles", 1, image); } },
+			{ "tiled-triangles-2", "raster-triangles", [](Image& image) { RenderTiled("triangles", 2, image); } },
+			{ "tiled-triangles-8", "raster-triangles", [](Image& image) { RenderTiled("triangles", 8, image); } },
+			{ "tiled-micro-4", "raster-micro", [](Image& image) { RenderTiled("micro", 4, image); } },
+			{ "streamed-micro-4", "raster-micro", [](Image& image) { RenderStreamed("micro", 4, image); } },
+			{ "hdr-triangles", nullptr, [](Image& image) { RenderHDR(1, image); } },
+			{ "hdr-triangles-4", "hdr-triangles", [](Image& image) { RenderHDR(4, image); } },
+			{ "lines", nullptr, [](Image& image) { RenderWireframe(false, 0, image); } },
+			{ "lines-tiled-4", "lines", [](Image& image) { RenderWireframe(false, 4, image); } },
+			{ "lines-aa", nullptr, [](Image& image) { RenderWireframe(true, 0, image); } },
+			{ "lines-aa-tiled-4", "lines-aa", [](Image& image) { RenderWireframe(true, 4, image); } },
+			{ "points", nullptr, [](Image& image) { RenderPoints(4, image); } },
+			{ "transparency", nullptr, [](Image& image) { RenderTransparent(0, image); } },
+			{ "transparency-tiled-4", "transparency", [](Image& image) { RenderTransparent(4, image); } },
+			{ "transparency-layers", nullptr, [](Image& image) { RenderLayers(false, image); } },
+			{ "transparency-layers-reversed", "transparency-layers", [](Image& image) { RenderLayers(true, image); } },
+			{ "shadows", nullptr, [](Image& image) { RenderShadows(image); } },
+			{ "msaa-4x", nullptr, [](Image& image) { RenderMultisample(4, 16, image); } },
+			{ "msaa-4x-tile8", "msaa-4x", [](Image& image) { RenderMultisample(4, 8, image); } },
+			{ "msaa-8x", nullptr, [](Image& image) { RenderMultisample(8, 16, image); } },
+			{ "msaa-1x-triangles", "raster-triangles", [](Image& image) { RenderMultisampleScene("triangles", 1, image); } },
+			{ "msaa-1x-micro", "raster-micro", [](Image& image) { RenderMultisampleScene("micro", 1, image); } },
+			{ "msaa-4x-triangles", nullptr, [](Image& image) { RenderMultisampleScene("triangles", 4, image); } },
+			{ "msaa-1x-lines", "lines", [](Image& image) { RenderMultisampleLines(false, false, 1, image); } },
+			{ "msaa-1x-points", "points", [](Image& image) { RenderMultisampleLines(true, false, 1, image); } },
+			{ "msaa-4x-lines-aa", nullptr, [](Image& image) { RenderMultisampleLines(false, true, 4, image); } }
+		};
+
+		std::vector<std::pair<std::string, Image>> rendered;
+		uint32_t failed = 0;
+
+		for (const Case& c : cases)
+		{
+			Image image;
+			c.render(image);
+
+			std::string base = directory + "/" + c.name;
+			Image expected;
+			bool exact = c.reference != nullptr;
+			bool loaded = false;
+
+			if (exact)
+			{
+				for (const std::pair<std::string, Image>& r : rendered)
+				{
+					if (r.first == c.reference)
+					{
+						expected = r.second;
+						loaded = true;
+					}
+				}
+			}
+			else if (update)
+			{
+				bool saved = SavePPM(base + ".ppm", image.data(), Width, Height);
+				output << (saved ? "UPDATED " : "FAIL ") << c.name << (saved ? "" : " cannot write golden") << std::endl;
+				failed += saved ? 0 : 1;
+				rendered.push_back(std::make_pair(std::string(c.name), image));
+				continue;
+			}
+			else
+			{
+				uint32_t width = 0;
+				uint32_t height = 0;
+				loaded = LoadPPM(base + ".ppm", width, height, expected) && width == Width && height == Height;
+			}
+
+			rendered.push_back(std::make_pair(std::string(c.name), image));
+			if (!loaded)
+			{
+				output << "FAIL " << c.name << " missing " << (exact ? std::string(c.reference) : base + ".ppm") << std::endl;
+				failed++;
+				continue;
+			}
+
+			// Golden alpha is not stored, compare color only
+			Image diffImage;
+			ImageDiff diff = Compare(image.data(), expected.data(), Width, Height, PerceptualThreshold, &diffImage);
+			bool passed = exact ? diff.differing == 0 : diff.perceptible == 0;
+
+			output << (passed ? "PASS " : "FAIL ") << c.name << (exact ? " == " + std::string(c.reference) : std::string(" vs golden"))
+				<< " differing = " << diff.differing << " perceptible = " << diff.perceptible << " max = " << diff.maxError
+				<< " psnr = " << diff.psnr << " dB" << std::endl;
+
+			if (!passed)
+			{
+				SavePPM(base + ".diff.ppm", diffImage.data(), Width, Height);
+				SavePPM(base + ".out.ppm", image.data(), Width, Height);
+				failed++;
+			}
+		}
+
+		output << (failed ? "FAILED " : "PASSED ") << (sizeof(cases) / sizeof(cases[0]) - failed) << " / " << sizeof(cases) / sizeof(cases[0]) << std::endl;
+		return failed;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Verify
+{
+	/**
+	 * @struct ImageDiff
+	 * @brief Differences between two RGBA8 images, alpha is ignored.
+	 */
+	struct ImageDiff
+	{
+		/** @brief Pixels with any channel different. */
+		uint32_t differing;
+		/** @brief Pixels whose perceptual error exceeds the threshold. */
+		uint32_t perceptible;
+		/** @brief Largest absolute channel difference. */
+		uint32_t maxError;
+		/** @brief Peak signal to noise ratio in dB over RGB, infinite for identical images. */
+		double psnr;
+	};
+
+	/**
+	 * @brief Compares images pixel by pixel.
+	 *
+	 * Perceptual error is the YCbCr distance with chroma at half weight (the eye resolves luma differences
+	 * best), in 8 bit units. If diffImage is given it receives the reference darkened to a quarter with every
+	 * differing pixel in red, brighter for larger errors.
+	 */
+	ImageDiff Compare(const uint32_t* image, const uint32_t* reference, uint32_t width, uint32_t height, float threshold, std::vector<uint32_t>* diffImage);
+
+	bool LoadPPM(const std::string& path, uint32_t& width, uint32_t& height, std::vector<uint32_t>& pixels);
+	bool SavePPM(const std::string& path, const uint32_t* pixels, uint32_t width, uint32_t height);
+
+	/**
+	 * @brief Renders canned scenes through every kernel and checks them.
+	 *
+	 * Reference cases are compared against <directory>/<case>.ppm within perceptual tolerance (goldens may come
+	 * from another compiler), failing ones write <case>.diff.ppm and <case>.out.ppm next to it. Variant cases
+	 * (other thread counts, small triangle path off, tiled, streamed) must match their reference case exactly,
+	 * so optimizations cannot change output silently.
+	 *
+	 * @param update Writes reference renders as new goldens instead of comparing.
+	 * @return Number of failed cases.
+	 */
+	uint32_t RunGoldenTests(const std::string& directory, bool update, std::ostream& output);
+}